@@ -0,0 +1,302 @@
+#include "stdafx.h"
+#include "Benchmark.h"
+#include "FlatMap.h"
+#include "Resource.h"
+#include "StringArena.h"
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <string.h>
+
+using namespace std;
+
+const size_t BENCH_MAP_SIZES[] = { 100, 10000, 1000000 };
+const size_t BENCH_MIN_LOOKUPS = 2000000;
+const size_t BENCH_DESCRIPTOR_COUNT = 100000;
+
+namespace
+{
+	// The descriptors the queue used to hold: one heap object per resource,
+	// told apart with dynamic_cast
+	struct LegacyResource
+	{
+		LegacyResource(string key, ResourcePriority priority) : m_key(key), m_priority(priority) {}
+		virtual ~LegacyResource() {}
+
+		string				m_key;
+		ResourcePriority	m_priority;
+	};
+
+	struct LegacyTexture : LegacyResource
+	{
+		LegacyTexture(string key, string path, ResourcePriority priority) : LegacyResource(key, priority), m_textureDir(path) {}
+		string				m_textureDir;
+	};
+
+	struct LegacyMusic : LegacyResource
+	{
+		LegacyMusic(string key, string path, ResourcePriority priority) : LegacyResource(key, priority), m_musicDir(path) {}
+		string				m_musicDir;
+	};
+
+	struct LegacySoundEffect : LegacyResource
+	{
+		LegacySoundEffect(string key, string path, ResourcePriority priority) : LegacyResource(key, priority), m_soundEffectDir(path) {}
+		string				m_soundEffectDir;
+	};
+
+	struct ManifestLine
+	{
+		ResourceType		m_type;
+		string				m_key;
+		string				m_path;
+		ResourcePriority	m_priority;
+	};
+
+	struct QueueTimes
+	{
+		double	m_queue;		// Milliseconds to build the queue
+		double	m_schedule;		// Milliseconds to sort it by priority
+		double	m_dispatch;		// Milliseconds to route every entry to its loader
+		double	m_free;			// Milliseconds to release it
+	};
+
+	double elapsedMilliseconds(chrono::high_resolution_clock::time_point start)
+	{
+		chrono::duration<double, milli> _elapsed = chrono::high_resolution_clock::now() - start;
+		return _elapsed.count();
+	}
+
+	void printQueueTimes(const char* name, const QueueTimes& times)
+	{
+		cout << "  " << left << setw(12) << name << right << fixed << setprecision(2)
+			<< setw(9) << times.m_queue << " ms queue"
+			<< setw(9) << times.m_schedule << " ms schedule"
+			<< setw(9) << times.m_dispatch << " ms dispatch"
+			<< setw(9) << times.m_free << " ms free"
+			<< setw(9) << times.m_queue + times.m_schedule + times.m_dispatch + times.m_free << " ms total" << endl;
+	}
+
+	QueueTimes timeLegacyQueue(const vector<ManifestLine>& manifest, size_t* checksum)
+	{
+		QueueTimes _times;
+
+		auto _start = chrono::high_resolution_clock::now();
+		vector<LegacyResource*> _queue;
+		for (auto& line : manifest)
+		{
+			if (line.m_type == RESOURCE_TEXTURE)
+				_queue.push_back(new LegacyTexture(line.m_key, line.m_path, line.m_priority));
+			else if (line.m_type == RESOURCE_MUSIC)
+				_queue.push_back(new LegacyMusic(line.m_key, line.m_path, line.m_priority));
+			else
+				_queue.push_back(new LegacySoundEffect(line.m_key, line.m_path, line.m_priority));
+		}
+		_times.m_queue = elapsedMilliseconds(_start);
+
+		_start = chrono::high_resolution_clock::now();
+		vector<LegacyResource*> _schedule = _queue;
+		stable_sort(_schedule.begin(), _schedule.end(), [](LegacyResource* a, LegacyResource* b)
+		{
+			return a->m_priority < b->m_priority;
+		});
+		_times.m_schedule = elapsedMilliseconds(_start);
+
+		_start = chrono::high_resolution_clock::now();
+		for (auto& resource : _schedule)
+		{
+			LegacyTexture* _texture = dynamic_cast<LegacyTexture*>(resource);
+			LegacyMusic* _music = dynamic_cast<LegacyMusic*>(resource);
+			LegacySoundEffect* _soundEffect = dynamic_cast<LegacySoundEffect*>(resource);
+
+			if (_texture)
+				*checksum += _texture->m_textureDir.size();
+			else if (_music)
+				*checksum += _music->m_musicDir.size() * 3;
+			else
+				*checksum += _soundEffect->m_soundEffectDir.size() * 7;
+		}
+		_times.m_dispatch = elapsedMilliseconds(_start);
+
+		_start = chrono::high_resolution_clock::now();
+		for (auto& resource : _queue)
+			delete resource;
+		_times.m_free = elapsedMilliseconds(_start);
+
+		return _times;
+	}
+
+	QueueTimes timeDescriptorQueue(const vector<ManifestLine>& manifest, size_t* checksum)
+	{
+		QueueTimes _times;
+
+		auto _start = chrono::high_resolution_clock::now();
+		unique_ptr<StringArena> _strings(new StringArena());
+		vector<Resource> _queue;
+		for (auto& line : manifest)
+		{
+			Resource _resource;
+			_resource.m_key = _strings->store(line.m_key);
+			_resource.m_path = _strings->store(line.m_path);
+			_resource.m_type = line.m_type;
+			_resource.m_priority = line.m_priority;
+			_queue.push_back(_resource);
+		}
+		_times.m_queue = elapsedMilliseconds(_start);
+
+		_start = chrono::high_resolution_clock::now();
+		vector<Resource> _schedule = _queue;
+		stable_sort(_schedule.begin(), _schedule.end(), [](const Resource& a, const Resource& b)
+		{
+			return a.m_priority < b.m_priority;
+		});
+		_times.m_schedule = elapsedMilliseconds(_start);
+
+		_start = chrono::high_resolution_clock::now();
+		for (auto& resource : _schedule)
+		{
+			switch (resource.m_type)
+			{
+			case RESOURCE_TEXTURE:
+				*checksum += strlen(resource.m_path);
+				break;
+			case RESOURCE_MUSIC:
+				*checksum += strlen(resource.m_path) * 3;
+				break;
+			case RESOURCE_SOUND_EFFECT:
+				*checksum += strlen(resource.m_path) * 7;
+				break;
+			}
+		}
+		_times.m_dispatch = elapsedMilliseconds(_start);
+
+		_start = chrono::high_resolution_clock::now();
+		_schedule = vector<Resource>();
+		_queue = vector<Resource>();
+		_strings = nullptr;
+		_times.m_free = elapsedMilliseconds(_start);
+
+		return _times;
+	}
+
+	struct MapTimes
+	{
+		double	m_insert;		// Nanoseconds per insert
+		double	m_lookup;		// Nanoseconds per lookup
+	};
+
+	double elapsedNanoseconds(chrono::high_resolution_clock::time_point start, size_t operations)
+	{
+		chrono::duration<double, nano> _elapsed = chrono::high_resolution_clock::now() - start;
+		return _elapsed.count() / operations;
+	}
+
+	// Inserts every key into an empty map, then looks keys up in a shuffled
+	// order until at least BENCH_MIN_LOOKUPS lookups have been timed
+	template<typename Map, typename Find>
+	MapTimes timeMap(const vector<string>& keys, const vector<size_t>& order, Find find)
+	{
+		MapTimes _times;
+		size_t _found = 0;
+
+		{
+			Map _map;
+			auto _start = chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < keys.size(); i++)
+				_map[keys[i]] = (unsigned int)i;
+			_times.m_insert = elapsedNanoseconds(_start, keys.size());
+		}
+
+		Map _map;
+		for (size_t i = 0; i < keys.size(); i++)
+			_map[keys[i]] = (unsigned int)i;
+
+		size_t _rounds = max<size_t>(1, BENCH_MIN_LOOKUPS / keys.size());
+		auto _start = chrono::high_resolution_clock::now();
+		for (size_t r = 0; r < _rounds; r++)
+		{
+			for (size_t i = 0; i < order.size(); i++)
+				_found += find(_map, keys[order[i]]);
+		}
+		_times.m_lookup = elapsedNanoseconds(_start, _rounds * order.size());
+
+		// stops the lookups being optimised away
+		if (_found != _rounds * order.size())
+			cout << "Benchmark lookups missed " << _rounds * order.size() - _found << " keys" << endl;
+
+		return _times;
+	}
+
+	void printTimes(const char* name, const MapTimes& times)
+	{
+		cout << "  " << left << setw(16) << name << right << fixed << setprecision(1)
+			<< setw(10) << times.m_insert << " ns/insert"
+			<< setw(10) << times.m_lookup << " ns/lookup" << endl;
+	}
+}
+
+void benchmarkMaps()
+{
+	mt19937 _random(1617);
+
+	for (size_t size : BENCH_MAP_SIZES)
+	{
+		// keys shaped like manifest keys, inserted in a random order
+		vector<string> _keys(size);
+		for (size_t i = 0; i < size; i++)
+			_keys[i] = "resource_texture_" + to_string(i);
+		shuffle(_keys.begin(), _keys.end(), _random);
+
+		vector<size_t> _order(size);
+		for (size_t i = 0; i < size; i++)
+			_order[i] = i;
+		shuffle(_order.begin(), _order.end(), _random);
+
+		cout << size << " keys" << endl;
+
+		printTimes("std::map", timeMap<map<string, unsigned int>>(_keys, _order,
+			[](const map<string, unsigned int>& m, const string& k) { return m.find(k) != m.end(); }));
+
+		printTimes("unordered_map", timeMap<unordered_map<string, unsigned int>>(_keys, _order,
+			[](const unordered_map<string, unsigned int>& m, const string& k) { return m.find(k) != m.end(); }));
+
+		printTimes("FlatMap", timeMap<FlatMap<string, unsigned int>>(_keys, _order,
+			[](const FlatMap<string, unsigned int>& m, const string& k) { return m.find(k) != nullptr; }));
+	}
+}
+
+void benchmarkDescriptors()
+{
+	mt19937 _random(1617);
+
+	// a manifest shaped like the shipped ones: mostly textures, every priority in use
+	vector<ManifestLine> _manifest(BENCH_DESCRIPTOR_COUNT);
+	for (size_t i = 0; i < _manifest.size(); i++)
+	{
+		ManifestLine& _line = _manifest[i];
+		unsigned int _kind = _random() % 10;
+		_line.m_type = _kind < 7 ? RESOURCE_TEXTURE : (_kind < 8 ? RESOURCE_MUSIC : RESOURCE_SOUND_EFFECT);
+		_line.m_key = "resource_" + to_string(i);
+		_line.m_path = "Resources/Assets/resource_" + to_string(i) + (_kind < 7 ? ".png" : (_kind < 8 ? ".ogg" : ".wav"));
+		_line.m_priority = (ResourcePriority)(_random() % (PRIORITY_BACKGROUND + 1));
+	}
+
+	size_t _legacyChecksum = 0;
+	size_t _descriptorChecksum = 0;
+	QueueTimes _legacy = timeLegacyQueue(_manifest, &_legacyChecksum);
+	QueueTimes _descriptors = timeDescriptorQueue(_manifest, &_descriptorChecksum);
+
+	cout << _manifest.size() << " manifest entries" << endl;
+	printQueueTimes("polymorphic", _legacy);
+	printQueueTimes("descriptors", _descriptors);
+
+	if (_legacyChecksum != _descriptorChecksum)
+		cout << "Benchmark queues disagree" << endl;
+}
\ No newline at end of file
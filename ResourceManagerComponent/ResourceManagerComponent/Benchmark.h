@@ -0,0 +1,6 @@
+#pragma once
+
+// Micro benchmarks for the ResourceManager's data structures, run from the
+// command line with --bench-maps or --bench-descriptors. Results are printed to stdout.
+void benchmarkMaps();
+void benchmarkDescriptors();
\ No newline at end of file
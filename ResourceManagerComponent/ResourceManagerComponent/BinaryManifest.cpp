@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include "BinaryManifest.h"
+
+BinaryManifest::BinaryManifest() :
+m_header(nullptr),
+m_entries(nullptr),
+m_frames(nullptr),
+m_strings(nullptr)
+{}
+
+bool BinaryManifest::open(const string& fileName)
+{
+	close();
+
+	if (!m_file.open(fileName) || m_file.getSize() < sizeof(ManifestHeader))
+		return false;
+
+	const ManifestHeader* _header = (const ManifestHeader*)m_file.getData();
+	if (memcmp(_header->m_magic, MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC)) != 0 || _header->m_version != MANIFEST_VERSION)
+	{
+		close();
+		return false;
+	}
+
+	uint64_t _size = sizeof(ManifestHeader) + (uint64_t)_header->m_entryCount * sizeof(ManifestEntry) +
+		(uint64_t)_header->m_frameCount * sizeof(SDL_Rect) + _header->m_stringTableSize;
+	if (_size > m_file.getSize())
+	{
+		close();
+		return false;
+	}
+
+	const ManifestEntry* _entries = (const ManifestEntry*)(m_file.getData() + sizeof(ManifestHeader));
+	const SDL_Rect* _frames = (const SDL_Rect*)(_entries + _header->m_entryCount);
+	const char* _strings = (const char*)(_frames + _header->m_frameCount);
+
+	// keys and paths are handed out as C strings, so the last one has to be terminated
+	if (_header->m_stringTableSize > 0 && _strings[_header->m_stringTableSize - 1] != '\0')
+	{
+		close();
+		return false;
+	}
+
+	for (unsigned int i = 0; i < _header->m_entryCount; i++)
+	{
+		const ManifestEntry& _entry = _entries[i];
+		if (_entry.m_keyOffset >= _header->m_stringTableSize || _entry.m_pathOffset >= _header->m_stringTableSize ||
+			(uint64_t)_entry.m_firstFrame + _entry.m_frameCount > _header->m_frameCount || _entry.m_type > MANIFEST_ANIMATION)
+		{
+			close();
+			return false;
+		}
+	}
+
+	m_header = _header;
+	m_entries = _entries;
+	m_frames = _frames;
+	m_strings = _strings;
+
+	return true;
+}
+
+void BinaryManifest::close()
+{
+	m_file.close();
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_frames = nullptr;
+	m_strings = nullptr;
+}
+
+unsigned int BinaryManifest::getEntryCount() const
+{
+	return m_header ? m_header->m_entryCount : 0;
+}
+
+const ManifestEntry* BinaryManifest::getEntry(unsigned int index) const
+{
+	return &m_entries[index];
+}
+
+const char* BinaryManifest::getString(uint32_t offset) const
+{
+	return m_strings + offset;
+}
+
+const SDL_Rect* BinaryManifest::getFrames(const ManifestEntry* entry) const
+{
+	return m_frames + entry->m_firstFrame;
+}
+
+bool BinaryManifest::build(const string& fileName, const vector<ManifestSource>& sources)
+{
+	vector<ManifestEntry> _entries(sources.size());
+	vector<SDL_Rect> _frames;
+	string _strings;
+
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		const ManifestSource& _source = sources[i];
+		ManifestEntry& _entry = _entries[i];
+
+		_entry.m_keyOffset = _strings.size();
+		_strings.append(_source.m_key.c_str(), _source.m_key.size() + 1);
+		_entry.m_pathOffset = _strings.size();
+		_strings.append(_source.m_path.c_str(), _source.m_path.size() + 1);
+
+		_entry.m_type = (uint16_t)_source.m_type;
+		_entry.m_priority = (uint16_t)_source.m_priority;
+		_entry.m_firstFrame = _frames.size();
+		_entry.m_frameCount = _source.m_frames.size();
+
+		_frames.insert(_frames.end(), _source.m_frames.begin(), _source.m_frames.end());
+	}
+
+	FILE* _file = nullptr;
+	fopen_s(&_file, fileName.c_str(), "wb");
+	if (_file == nullptr)
+		return false;
+
+	ManifestHeader _header = ManifestHeader();
+	memcpy(_header.m_magic, MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC));
+	_header.m_version = MANIFEST_VERSION;
+	_header.m_entryCount = _entries.size();
+	_header.m_frameCount = _frames.size();
+	_header.m_stringTableSize = _strings.size();
+
+	fwrite(&_header, sizeof(_header), 1, _file);
+	if (!_entries.empty())
+		fwrite(_entries.data(), sizeof(ManifestEntry), _entries.size(), _file);
+	if (!_frames.empty())
+		fwrite(_frames.data(), sizeof(SDL_Rect), _frames.size(), _file);
+	fwrite(_strings.data(), 1, _strings.size(), _file);
+
+	bool _success = ferror(_file) == 0;
+	fclose(_file);
+
+	cout << "Compiled " + to_string(_entries.size()) + " entries into " + fileName << endl;
+	return _success;
+}
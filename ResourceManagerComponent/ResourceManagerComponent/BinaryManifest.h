@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "SDL_rect.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+// A manifest compiled offline from a .txt, .json or .xml manifest:
+//
+//   ManifestHeader | ManifestEntry[entryCount] | SDL_Rect[frameCount] | string table
+//
+// Everything is fixed size and read straight out of the mapping, so
+// loading it involves no parsing.
+
+const char MANIFEST_MAGIC[4] = { 'R', 'M', 'A', 'N' };
+const uint32_t MANIFEST_VERSION = 1;
+
+enum ManifestEntryType
+{
+	MANIFEST_TEXTURE,
+	MANIFEST_MUSIC,
+	MANIFEST_SOUND_EFFECT,
+	MANIFEST_ANIMATION				// A texture with a run of frames
+};
+
+struct ManifestHeader
+{
+	char		m_magic[4];
+	uint32_t	m_version;
+	uint32_t	m_entryCount;
+	uint32_t	m_frameCount;
+	uint32_t	m_stringTableSize;
+};
+
+struct ManifestEntry
+{
+	uint32_t	m_keyOffset;		// Into the string table, null terminated
+	uint32_t	m_pathOffset;
+	uint16_t	m_type;
+	uint16_t	m_priority;
+	uint32_t	m_firstFrame;		// Into the frame table
+	uint32_t	m_frameCount;
+};
+
+struct ManifestSource
+{
+	string				m_key;
+	string				m_path;
+	ManifestEntryType	m_type;
+	int					m_priority;
+	vector<SDL_Rect>	m_frames;
+};
+
+class BinaryManifest
+{
+public:
+	BinaryManifest();
+
+	bool									open(const string& fileName);
+	void									close();
+
+	unsigned int							getEntryCount() const;
+	const ManifestEntry*					getEntry(unsigned int index) const;
+	const char*								getString(uint32_t offset) const;
+	const SDL_Rect*							getFrames(const ManifestEntry* entry) const;
+
+	static bool								build(const string& fileName, const vector<ManifestSource>& sources);
+
+private:
+	MappedFile								m_file;
+	const ManifestHeader*					m_header;
+	const ManifestEntry*					m_entries;
+	const SDL_Rect*							m_frames;
+	const char*								m_strings;
+};
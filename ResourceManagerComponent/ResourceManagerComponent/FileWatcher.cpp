@@ -0,0 +1,276 @@
+#include "stdafx.h"
+#include "FileWatcher.h"
+#include "Hash.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <chrono>
+#include <sys/stat.h>
+
+#if defined(_WIN64) || defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+const size_t QUEUE_CAPACITY = 4096;
+const int WAIT_MILLISECONDS = 100;				// How long the watcher sleeps before it looks for new watch requests
+
+FileWatcher::FileWatcher(float pollInterval) :
+m_pollInterval(pollInterval),
+m_requests(QUEUE_CAPACITY),
+m_changes(QUEUE_CAPACITY),
+m_running(true)
+{
+#if defined(__linux__)
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotify < 0)
+		cout << "inotify is unavailable, polling for file changes" << endl;
+#endif
+
+	m_thread = thread(&FileWatcher::run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+	m_running = false;
+	m_thread.join();
+
+#if defined(__linux__)
+	if (m_inotify >= 0)
+		close(m_inotify);
+#endif
+}
+
+void FileWatcher::watch(const string& path)
+{
+	m_unrequested.push_back(path);
+	flushRequests();
+}
+
+bool FileWatcher::popChange(string* path)
+{
+	flushRequests();
+	return m_changes.pop(path);
+}
+
+void FileWatcher::flushRequests()
+{
+	size_t _sent = 0;
+	while (_sent < m_unrequested.size() && m_requests.push(m_unrequested[_sent]))
+		_sent++;
+
+	m_unrequested.erase(m_unrequested.begin(), m_unrequested.begin() + _sent);
+}
+
+void FileWatcher::run()
+{
+	chrono::steady_clock::time_point _nextPoll = chrono::steady_clock::now();
+
+	while (m_running)
+	{
+		string _path;
+		while (m_requests.pop(&_path))
+			addWatch(_path);
+
+		vector<string> _changed;
+		_changed.swap(m_unsent);
+
+#if defined(__linux__)
+		if (m_inotify >= 0)
+		{
+			// sleeps until the kernel has events, so an idle watcher costs nothing
+			pollfd _descriptor = { m_inotify, POLLIN, 0 };
+			if (poll(&_descriptor, 1, WAIT_MILLISECONDS) > 0)
+				readEvents(&_changed);
+		}
+		else
+#endif
+			this_thread::sleep_for(chrono::milliseconds(WAIT_MILLISECONDS));
+
+		if (chrono::steady_clock::now() >= _nextPoll)
+		{
+			pollFiles(&_changed, false);
+			_nextPoll = chrono::steady_clock::now() + chrono::milliseconds((int)(m_pollInterval * 1000));
+		}
+
+		// nothing is dropped when the game thread falls behind, it is sent on a later pass
+		for (size_t i = 0; i < _changed.size(); i++)
+		{
+			if (!m_changes.push(_changed[i]))
+			{
+				m_unsent.assign(_changed.begin() + i, _changed.end());
+				break;
+			}
+		}
+	}
+}
+
+void FileWatcher::addWatch(const string& path)
+{
+	if (m_index.find(path))
+		return;
+
+	WatchedFile _file;
+	_file.m_path = path;
+	_file.m_stamp = getFileStamp(path);
+	_file.m_contentHash = _file.m_stamp.m_exists ? hashContents(path) : 0;
+	_file.m_hashed = _file.m_stamp.m_exists;
+	_file.m_polled = true;
+
+#if defined(__linux__)
+	if (m_inotify >= 0)
+	{
+		// editors and build tools often replace a file instead of writing it, so the directory is watched
+		size_t _slash = path.find_last_of("/\\");
+		string _directory = _slash == string::npos ? "" : path.substr(0, _slash + 1);
+
+		int _watch = inotify_add_watch(m_inotify, _directory.empty() ? "." : _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (_watch >= 0)
+		{
+			m_directories[_watch] = _directory;
+			_file.m_polled = false;
+		}
+	}
+#endif
+
+	m_index[path] = m_files.size();
+	m_files.push_back(_file);
+}
+
+bool FileWatcher::isEventDriven() const
+{
+#if defined(__linux__)
+	return m_inotify >= 0;
+#else
+	return false;
+#endif
+}
+
+#if defined(__linux__)
+void FileWatcher::readEvents(vector<string>* changed)
+{
+	alignas(inotify_event) char _buffer[4096];
+
+	for (;;)
+	{
+		ssize_t _read = read(m_inotify, _buffer, sizeof(_buffer));
+		if (_read <= 0)
+			return;
+
+		for (char* _next = _buffer; _next < _buffer + _read;)
+		{
+			const inotify_event* _event = (const inotify_event*)_next;
+			_next += sizeof(inotify_event) + _event->len;
+
+			// the kernel dropped events, so nothing it reported can be trusted to be complete
+			if (_event->mask & IN_Q_OVERFLOW)
+			{
+				pollFiles(changed, true);
+				continue;
+			}
+
+			const string* _directory = m_directories.find(_event->wd);
+			if (!_directory || _event->len == 0)
+				continue;
+
+			string _path = *_directory + _event->name;
+			const size_t* _index = m_index.find(_path);
+			if (!_index)
+				continue;
+
+			if (checkFile(&m_files[*_index]) && find(changed->begin(), changed->end(), _path) == changed->end())
+				changed->push_back(_path);
+		}
+	}
+}
+#endif
+
+// Stats the polled files, or every file when events may have been lost
+void FileWatcher::pollFiles(vector<string>* changed, bool all)
+{
+	for (auto& file : m_files)
+	{
+		if (!file.m_polled && !all)
+			continue;
+
+		if (checkFile(&file) && find(changed->begin(), changed->end(), file.m_path) == changed->end())
+			changed->push_back(file.m_path);
+	}
+}
+
+// A file is only changed when its contents are, so a build tool rewriting identical bytes reloads nothing.
+// The baseline hash is taken on this thread when the watch is added. Only a file that did not exist
+// then is reported on its first write, as there is nothing to compare it with.
+bool FileWatcher::checkFile(WatchedFile* file)
+{
+	FileStamp _stamp = getFileStamp(file->m_path);
+	if (_stamp == file->m_stamp)
+		return false;
+	file->m_stamp = _stamp;
+
+	// a deleted file has nothing to reload, it is reported again once something is written in its place
+	if (!_stamp.m_exists)
+		return false;
+
+	uint64_t _hash = hashContents(file->m_path);
+	bool _changed = !file->m_hashed || _hash != file->m_contentHash;
+	file->m_contentHash = _hash;
+	file->m_hashed = true;
+
+	return _changed;
+}
+
+#if defined(_WIN64) || defined(_WIN32)
+
+FileStamp FileWatcher::getFileStamp(const string& path)
+{
+	FileStamp _stamp;
+	WIN32_FILE_ATTRIBUTE_DATA _attributes;
+	if (GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &_attributes))
+	{
+		_stamp.m_modified = ((int64_t)_attributes.ftLastWriteTime.dwHighDateTime << 32) | _attributes.ftLastWriteTime.dwLowDateTime;
+		_stamp.m_size = ((uint64_t)_attributes.nFileSizeHigh << 32) | _attributes.nFileSizeLow;
+		_stamp.m_exists = true;
+	}
+
+	return _stamp;
+}
+
+#else
+
+FileStamp FileWatcher::getFileStamp(const string& path)
+{
+	FileStamp _stamp;
+	struct stat _result;
+	if (stat(path.c_str(), &_result) == 0)
+	{
+#if defined(__APPLE__)
+		_stamp.m_modified = (int64_t)_result.st_mtimespec.tv_sec * 1000000000 + _result.st_mtimespec.tv_nsec;
+#else
+		_stamp.m_modified = (int64_t)_result.st_mtim.tv_sec * 1000000000 + _result.st_mtim.tv_nsec;
+#endif
+		_stamp.m_size = _result.st_size;
+		_stamp.m_exists = true;
+	}
+
+	return _stamp;
+}
+
+#endif
+
+// Read instead of mapped: an editor truncating the file while it is hashed would fault a mapping
+uint64_t FileWatcher::hashContents(const string& path)
+{
+	ifstream _file(path, ios::binary);
+	if (!_file.is_open())
+		return 0;
+
+	vector<char> _contents((istreambuf_iterator<char>(_file)), istreambuf_iterator<char>());
+	return xxhash64(_contents.data(), _contents.size());
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+#include "FlatMap.h"
+#include "SpscQueue.h"
+
+using namespace std;
+
+// What stat says about a file, compared before its contents are hashed
+struct FileStamp
+{
+	FileStamp() : m_modified(0), m_size(0), m_exists(false) {}
+
+	bool operator==(const FileStamp& other) const
+	{
+		return m_modified == other.m_modified && m_size == other.m_size && m_exists == other.m_exists;
+	}
+
+	int64_t		m_modified;		// Nanoseconds on Linux, 100ns ticks on Windows
+	uint64_t	m_size;
+	bool		m_exists;
+};
+
+// Reports which of a set of files changed on disk.
+// All the checking happens on the watcher's own thread, which hands changed
+// paths to the game thread through a lock-free queue, so the game thread never
+// touches file metadata. On Linux the directories holding the files are
+// watched with inotify, so nothing is checked until the kernel reports a
+// write. Anywhere else, or for a file whose directory cannot be watched, the
+// file is stat'ed once per poll interval instead. Either way a file is hashed
+// when its watch is added and again whenever its stamp moves, and is only
+// reported when its contents really changed. Deleted files are not reported.
+class FileWatcher
+{
+public:
+	FileWatcher(float pollInterval);
+	~FileWatcher();
+
+	// Game thread only
+	void									watch(const string& path);
+	bool									popChange(string* path);
+	bool									isEventDriven() const;
+
+private:
+	struct WatchedFile
+	{
+		string								m_path;
+		FileStamp							m_stamp;
+		uint64_t							m_contentHash;
+		bool								m_hashed;			// False while the file has never existed, so there is no baseline
+		bool								m_polled;
+	};
+
+	// owned by the watcher thread
+	vector<WatchedFile>						m_files;
+	FlatMap<string, size_t>					m_index;			// Into m_files, by path
+	vector<string>							m_unsent;			// Changes that did not fit in m_changes yet
+	float									m_pollInterval;
+
+	SpscQueue<string>						m_requests;			// Paths to start watching, game thread to watcher
+	SpscQueue<string>						m_changes;			// Changed paths, watcher to game thread
+	vector<string>							m_unrequested;		// Paths that did not fit in m_requests yet, game thread only
+
+	atomic<bool>							m_running;
+	thread									m_thread;
+
+#if defined(__linux__)
+	int										m_inotify;
+	FlatMap<int, string>					m_directories;		// Watched directory prefixes, by watch descriptor
+
+	void									readEvents(vector<string>* changed);
+#endif
+
+	void									run();
+	void									addWatch(const string& path);
+	void									flushRequests();
+	void									pollFiles(vector<string>* changed, bool all);
+	bool									checkFile(WatchedFile* file);
+	static FileStamp						getFileStamp(const string& path);
+	static uint64_t							hashContents(const string& path);
+
+	FileWatcher(const FileWatcher&);
+	FileWatcher&							operator=(const FileWatcher&);
+};
\ No newline at end of file
@@ -0,0 +1,180 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <utility>
+#include <stdint.h>
+
+using namespace std;
+
+// An open-addressing hash map with linear probing. Keys and values sit in one
+// flat array, so a lookup touches a couple of neighbouring slots instead of
+// chasing tree nodes, and inserts only allocate when the table grows.
+// Inserting may move every element, so pointers and iterators into the map
+// are invalidated by operator[] and erase.
+template<typename K, typename V, typename H = hash<K>>
+class FlatMap
+{
+public:
+	typedef pair<K, V>	value_type;
+
+	template<typename M, typename T>
+	class Iterator
+	{
+	public:
+		Iterator(M* map, size_t index) : m_map(map), m_index(index) { skipEmpty(); }
+
+		T&						operator*() const { return m_map->m_slots[m_index]; }
+		T*						operator->() const { return &m_map->m_slots[m_index]; }
+		Iterator&				operator++() { ++m_index; skipEmpty(); return *this; }
+		bool					operator==(const Iterator& other) const { return m_index == other.m_index; }
+		bool					operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+	private:
+		M*						m_map;
+		size_t					m_index;
+
+		void					skipEmpty() { while (m_index < m_map->m_used.size() && !m_map->m_used[m_index]) ++m_index; }
+	};
+
+	typedef Iterator<FlatMap, value_type>				iterator;
+	typedef Iterator<const FlatMap, const value_type>	const_iterator;
+
+	FlatMap() : m_size(0), m_shift(64) {}
+
+	size_t						size() const { return m_size; }
+	bool						empty() const { return m_size == 0; }
+
+	iterator					begin() { return iterator(this, 0); }
+	iterator					end() { return iterator(this, m_slots.size()); }
+	const_iterator				begin() const { return const_iterator(this, 0); }
+	const_iterator				end() const { return const_iterator(this, m_slots.size()); }
+
+	void clear()
+	{
+		m_slots.clear();
+		m_used.clear();
+		m_size = 0;
+		m_shift = 64;
+	}
+
+	// Sizes the table so count keys fit without growing again
+	void reserve(size_t count)
+	{
+		size_t _capacity = 16;
+		while (_capacity * 3 < count * 4)
+			_capacity *= 2;
+
+		if (_capacity > m_slots.size())
+			rehash(_capacity);
+	}
+
+	V* find(const K& key)
+	{
+		size_t _index = findIndex(key);
+		return _index != NOT_FOUND ? &m_slots[_index].second : nullptr;
+	}
+
+	const V* find(const K& key) const
+	{
+		size_t _index = findIndex(key);
+		return _index != NOT_FOUND ? &m_slots[_index].second : nullptr;
+	}
+
+	V& operator[](const K& key)
+	{
+		size_t _index = findIndex(key);
+		if (_index != NOT_FOUND)
+			return m_slots[_index].second;
+
+		// keep the load factor at or below 3/4 so probe runs stay short
+		if ((m_size + 1) * 4 > m_slots.size() * 3)
+			rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+
+		size_t _mask = m_slots.size() - 1;
+		for (_index = homeIndex(key); m_used[_index]; _index = (_index + 1) & _mask) {}
+
+		m_slots[_index] = value_type(key, V());
+		m_used[_index] = 1;
+		m_size++;
+		return m_slots[_index].second;
+	}
+
+	bool erase(const K& key)
+	{
+		size_t _hole = findIndex(key);
+		if (_hole == NOT_FOUND)
+			return false;
+
+		// shift later members of the probe run back so no tombstones are needed
+		size_t _mask = m_slots.size() - 1;
+		for (size_t _next = (_hole + 1) & _mask; m_used[_next]; _next = (_next + 1) & _mask)
+		{
+			size_t _home = homeIndex(m_slots[_next].first);
+			if (((_next - _home) & _mask) >= ((_next - _hole) & _mask))
+			{
+				m_slots[_hole] = move(m_slots[_next]);
+				_hole = _next;
+			}
+		}
+
+		m_slots[_hole] = value_type();
+		m_used[_hole] = 0;
+		m_size--;
+		return true;
+	}
+
+private:
+	static const size_t			NOT_FOUND = (size_t)-1;
+
+	vector<value_type>			m_slots;
+	vector<unsigned char>		m_used;
+	size_t						m_size;
+	unsigned int				m_shift;	// 64 - log2(capacity)
+
+	// Fibonacci hashing spreads weak hashes, such as the identity hash of integers, over the table
+	size_t homeIndex(const K& key) const
+	{
+		return (size_t)(((uint64_t)H()(key) * 11400714819323198485ull) >> m_shift);
+	}
+
+	size_t findIndex(const K& key) const
+	{
+		if (m_size == 0)
+			return NOT_FOUND;
+
+		size_t _mask = m_slots.size() - 1;
+		for (size_t _index = homeIndex(key); m_used[_index]; _index = (_index + 1) & _mask)
+		{
+			if (m_slots[_index].first == key)
+				return _index;
+		}
+
+		return NOT_FOUND;
+	}
+
+	void rehash(size_t capacity)
+	{
+		vector<value_type> _slots(capacity);
+		vector<unsigned char> _used(capacity, 0);
+		_slots.swap(m_slots);
+		_used.swap(m_used);
+
+		m_shift = 64;
+		for (size_t _capacity = capacity; _capacity > 1; _capacity >>= 1)
+			m_shift--;
+
+		size_t _mask = capacity - 1;
+		for (size_t i = 0; i < _slots.size(); i++)
+		{
+			if (!_used[i])
+				continue;
+
+			size_t _index = homeIndex(_slots[i].first);
+			while (m_used[_index])
+				_index = (_index + 1) & _mask;
+
+			m_slots[_index] = move(_slots[i]);
+			m_used[_index] = 1;
+		}
+	}
+};
\ No newline at end of file
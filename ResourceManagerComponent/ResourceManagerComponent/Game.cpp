@@ -7,6 +7,12 @@ const int SCREEN_FPS = 100;
 const int SCREEN_TICKS_PER_FRAME = 1000 / SCREEN_FPS;
 const float	SCREEN_WIDTH = 1200.0f;
 const float	SCREEN_HEIGHT = 1200.0f;
+const float	RESOURCE_FRAME_BUDGET = 2.0f;						// ms per frame the resource manager may spend loading
+const string	TEXTURE_CACHE_DIRECTORY = "Cache/Textures";			// Decoded textures kept on disk between runs
+const uint64_t	TEXTURE_CACHE_SIZE = 256 * 1024 * 1024;
+const int		ATLAS_PAGE_SIZE = 2048;
+const int		ATLAS_MAX_SPRITE_SIZE = 512;							// Anything bigger keeps its own texture
+const bool		LAZY_LOADING = true;									// Resources load when first used instead of at startup
 
 Game::Game():
 m_lastTime(0),
@@ -14,6 +20,7 @@ m_startTicks(0),
 m_currentFrame(0),
 m_animationDelay(0),
 m_quit(false), 
+m_filesLoaded(false),
 m_resourceManager(nullptr)
 {}
 
@@ -53,11 +60,20 @@ bool Game::init()
 
 	SDL_SetRenderDrawBlendMode(m_renderer, SDL_BLENDMODE_BLEND);
 
+	setupResourceManager();
+
+	return true;
+}
+
+void Game::setupResourceManager()
+{
 	// get a pointer to the resource manager and initialiase it with the renderer
 	m_resourceManager = ResourceManager::getInstance();
 	m_resourceManager->init(m_renderer);
-
-	return true;
+	m_resourceManager->setFrameBudget(RESOURCE_FRAME_BUDGET);
+	m_resourceManager->enableTextureCache(TEXTURE_CACHE_DIRECTORY, TEXTURE_CACHE_SIZE);
+	m_resourceManager->enableTextureAtlas(ATLAS_PAGE_SIZE, ATLAS_MAX_SPRITE_SIZE);
+	m_resourceManager->setLazyLoading(LAZY_LOADING);
 }
 
 void Game::destroy()
@@ -75,6 +91,9 @@ void Game::loop()
 	{
 		processInput();
 
+		if (m_loadHandle)
+			updateLoading();
+
 		if (m_filesLoaded)
 		{
 			update();
@@ -91,7 +110,7 @@ void Game::update()
 	m_animationDelay += _deltaTime;
 
 	// Update the resource manager to monitor changes in the files
-	m_resourceManager->update(_deltaTime);
+	m_resourceManager->update();
 
 	m_lastTime = _currentTime;
 }
@@ -131,54 +150,51 @@ void Game::processInput()
 			switch (_e.key.keysym.sym)
 			{
 			case SDLK_1:
-				if (!m_filesLoaded)
+				if (!m_filesLoaded && !m_loadHandle)
 				{
 					m_resourceManager->loadResourcesFromText("Resources/resources.txt");
-					m_resourceManager->loadResourceQueue();
-
-					m_gameMusic = m_resourceManager->getMusicByKey("game_music");
-					m_jump = m_resourceManager->getSoundEffectByKey("jump");
-					m_land = m_resourceManager->getSoundEffectByKey("land");
-
-					m_filesLoaded = true;
+					m_loadHandle = m_resourceManager->loadResourceQueueAsync();
+					resolveHandles();
 				}
 				break;
 			case SDLK_2:
-				if (!m_filesLoaded)
+				if (!m_filesLoaded && !m_loadHandle)
 				{
 					m_resourceManager->loadResourcesFromXML("Resources/resources.xml");
-					m_resourceManager->loadResourceQueue();
-
-					m_gameMusic = m_resourceManager->getMusicByKey("game_music");
-					m_jump = m_resourceManager->getSoundEffectByKey("jump");
-					m_land = m_resourceManager->getSoundEffectByKey("land");
-
-					m_filesLoaded = true;
+					m_loadHandle = m_resourceManager->loadResourceQueueAsync();
+					resolveHandles();
 				}
 				break;
 			case SDLK_3:
-				if (!m_filesLoaded)
+				if (!m_filesLoaded && !m_loadHandle)
 				{
 					m_resourceManager->loadResourcesFromJSON("Resources/resources.json");
-					m_resourceManager->loadResourceQueue();
-					
-					m_gameMusic = m_resourceManager->getMusicByKey("game_music");
-					m_jump = m_resourceManager->getSoundEffectByKey("jump");
-					m_land = m_resourceManager->getSoundEffectByKey("land");
-
-					m_filesLoaded = true;
+					m_loadHandle = m_resourceManager->loadResourceQueueAsync();
+					resolveHandles();
+				}
+				break;
+			case SDLK_4:
+				if (!m_filesLoaded && !m_loadHandle)
+				{
+					m_resourceManager->loadResourcesFromPack("Resources/resources.pak");
+					m_loadHandle = m_resourceManager->loadResourceQueueAsync();
+					resolveHandles();
+				}
+				break;
+			case SDLK_5:
+				if (!m_filesLoaded && !m_loadHandle)
+				{
+					m_resourceManager->loadResourcesFromBinary("Resources/resources.rman");
+					m_loadHandle = m_resourceManager->loadResourceQueueAsync();
+					resolveHandles();
 				}
 				break;
 			case SDLK_d:
-				if (m_filesLoaded)
+				if (m_filesLoaded && !m_loadHandle)
 				{
-					m_gameMusic = nullptr;
-					m_jump = nullptr;
-					m_land = nullptr;
-
 					m_resourceManager->destroy();
-					m_resourceManager = ResourceManager::getInstance();
-					m_resourceManager->init(m_renderer);
+					setupResourceManager();
+					resolveHandles();
 
 					m_filesLoaded = false;
 				}
@@ -186,7 +202,7 @@ void Game::processInput()
 			case SDLK_p:					// Play / Pause music
 				if (Mix_PlayingMusic() == 0)
 				{
-					if (Mix_PlayMusic(m_gameMusic, -1) == -1)
+					if (!m_resourceManager->playMusic(m_gameMusic, -1))
 						cout << "Problem playing game music!!" << endl;
 				}
 				else
@@ -199,15 +215,28 @@ void Game::processInput()
 
 				break;
 			case SDLK_j:					// Play jump sound effect
-				if (Mix_PlayChannel(-1, m_jump, 0) == -1)
+				if (Mix_PlayChannel(-1, m_resourceManager->getSoundEffect(m_jump), 0) == -1)
 					cout << "Problem playing jump sound effect!!" << endl;
 				
 				break;
 			case SDLK_l:					// Play shoot sound effect
-				if (Mix_PlayChannel(-1, m_land, 0) == -1)
+				if (Mix_PlayChannel(-1, m_resourceManager->getSoundEffect(m_land), 0) == -1)
 					cout << "Problem playing land sound effect!!" << endl;
 
 				break;
+			case SDLK_g:					// Load / unload the end of level resources
+				if (m_resourceManager->isGroupLoaded("level_end"))
+					m_resourceManager->unloadGroup("level_end");
+				else
+					m_resourceManager->loadGroup("level_end");
+				break;
+			case SDLK_m:					// Print memory usage
+				printMemoryStats();
+				break;
+			case SDLK_k:					// Print keys the game asked for that no manifest has
+				for (auto& miss : m_resourceManager->getMissReport())
+					cout << "Missing " << miss.m_kind << " " << miss.m_key << ": " << miss.m_count << " lookups" << endl;
+				break;
 			}
 			break;
 
@@ -217,49 +246,114 @@ void Game::processInput()
 	}
 }
 
-void Game::renderSprite()
+void Game::updateLoading()
 {
-	SDL_Texture* _playerTexture = m_resourceManager->getTextureByKey("player_texture");
+	// until the critical resources are in, the resource manager is pumped from here
+	if (!m_filesLoaded)
+	{
+		m_resourceManager->update();
+		m_lastTime = SDL_GetTicks();
 
-	int _w, _h;
-	SDL_QueryTexture(_playerTexture, NULL, NULL, &_w, &_h);
+		renderLoadingScreen();
+	}
 
-	SDL_Rect _src = SDL_Rect();
-	_src.h = _h;
-	_src.w = _w;
-	_src.x = 0;
-	_src.y = 0;
+	// the game can start drawing while the rest streams in
+	if (m_loadHandle->isCriticalComplete())
+		m_filesLoaded = true;
+
+	if (m_loadHandle->isComplete())
+	{
+		for (auto& error : m_loadHandle->getErrors())
+			cout << error << endl;
+
+		m_loadHandle = nullptr;
+	}
+}
+
+void Game::renderLoadingScreen()
+{
+	SDL_Rect _bar = SDL_Rect();
+	_bar.w = 800;
+	_bar.h = 40;
+	_bar.x = (int)(SCREEN_WIDTH - _bar.w) / 2;
+	_bar.y = (int)(SCREEN_HEIGHT - _bar.h) / 2;
+
+	SDL_Rect _fill = _bar;
+	_fill.w = (int)(_bar.w * m_loadHandle->getProgress());
+
+	SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);
+	SDL_RenderClear(m_renderer);
+
+	SDL_SetRenderDrawColor(m_renderer, 255, 255, 255, 255);
+	SDL_RenderDrawRect(m_renderer, &_bar);
+	SDL_RenderFillRect(m_renderer, &_fill);
+
+	SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);
+	SDL_RenderPresent(m_renderer);
+}
+
+void Game::resolveHandles()
+{
+	m_gameMusic = m_resourceManager->getMusicHandle("game_music"_rk);
+	m_jump = m_resourceManager->getSoundEffectHandle("jump"_rk);
+	m_land = m_resourceManager->getSoundEffectHandle("land"_rk);
+	m_playerSprite = m_resourceManager->getTextureHandle("player_texture"_rk);
+	m_bobSprite = m_resourceManager->getTextureHandle("bob"_rk);
+	m_bobAnimation = m_resourceManager->getAnimationHandle("bob"_rk);
+	m_stickManAnimation = m_resourceManager->getAnimationHandle("stick_man"_rk);
+
+	// the music is pinned so a memory budget never evicts it between plays
+	m_resourceManager->acquire(RESOURCE_MUSIC, m_gameMusic);
+
+	// audio is warmed up front so the first play is not the placeholder
+	m_resourceManager->prefetch({ "game_music", "jump", "land" });
+}
+
+void Game::printMemoryStats()
+{
+	const char* _typeNames[] = { "textures", "music", "sound effects" };
+	ResourceStats _stats = m_resourceManager->getStats(5);
+
+	cout << "Resident: " << _stats.m_totalBytes / 1024 << "KB, peak " << _stats.m_peakBytes / 1024 << "KB" << endl;
+	for (int i = RESOURCE_TEXTURE; i <= RESOURCE_SOUND_EFFECT; i++)
+		cout << "  " << _typeNames[i] << ": " << _stats.m_resident[i] << " resident, " << _stats.m_bytes[i] / 1024 << "KB" << endl;
+	cout << "  atlas pages: " << _stats.m_atlasBytes / 1024 << "KB" << endl;
+
+	cout << "Largest:" << endl;
+	for (auto& usage : _stats.m_largest)
+		cout << "  " << usage.m_key << " " << usage.m_bytes / 1024 << "KB" << endl;
+}
+
+void Game::renderSprite()
+{
+	Sprite _player = m_resourceManager->getSprite(m_playerSprite);
 
 	SDL_Rect _dest = SDL_Rect();
-	_dest.h = _h;
-	_dest.w = _w;
+	_dest.h = _player.m_source.h;
+	_dest.w = _player.m_source.w;
 	_dest.x = 600;
 	_dest.y = 600;
 
-	SDL_RenderCopy(m_renderer, _playerTexture, &_src, &_dest);
+	SDL_RenderCopy(m_renderer, _player.m_texture, &_player.m_source, &_dest);
 
-	SDL_Texture* _placeholder = m_resourceManager->getTextureByKey("bob");
+	Sprite _placeholder = m_resourceManager->getSprite(m_bobSprite);
 
-	SDL_QueryTexture(_placeholder, NULL, NULL, &_w, &_h);
-
-	_src.h = _h;
-	_src.w = _w;
-	_src.x = 0;
-	_src.y = 0;
-
-	_dest.h = _h;
-	_dest.w = _w;
+	_dest.h = _placeholder.m_source.h;
+	_dest.w = _placeholder.m_source.w;
 	_dest.x = 900;
 	_dest.y = 300;
 
-	SDL_RenderCopy(m_renderer, _placeholder, &_src, &_dest);
+	SDL_RenderCopy(m_renderer, _placeholder.m_texture, &_placeholder.m_source, &_dest);
 }
 
 void Game::renderAnimation()
 {
-	pair<SDL_Texture*, vector<SDL_Rect>> _placeholder = m_resourceManager->getAnimationByKey("bob");
+	AnimationClip _placeholder = m_resourceManager->getAnimation(m_bobAnimation);
+	AnimationClip _stickMan = m_resourceManager->getAnimation(m_stickManAnimation);
+	if (_placeholder.m_frameCount == 0 || _stickMan.m_frameCount == 0)
+		return;
 
-	SDL_Rect _src = _placeholder.second[m_currentFrame % _placeholder.second.size()];
+	SDL_Rect _src = _placeholder.getFrame(m_currentFrame);
 
 	SDL_Rect _dest = SDL_Rect();
 	_dest.w = _src.w;
@@ -267,23 +361,21 @@ void Game::renderAnimation()
 	_dest.x = 300;
 	_dest.y = 300;
 
-	SDL_RenderCopy(m_renderer, _placeholder.first, &_src, &_dest);
-
-	pair<SDL_Texture*, vector<SDL_Rect>> _stickMan = m_resourceManager->getAnimationByKey("stick_man");
+	SDL_RenderCopy(m_renderer, _placeholder.m_texture, &_src, &_dest);
 
-	_src = _stickMan.second[m_currentFrame % _stickMan.second.size()];
+	_src = _stickMan.getFrame(m_currentFrame);
 
 	_dest.w = _src.w;
 	_dest.h = _src.h;
 	_dest.x = 900;
 	_dest.y = 900;
 
-	SDL_RenderCopy(m_renderer, _stickMan.first, &_src, &_dest);
+	SDL_RenderCopy(m_renderer, _stickMan.m_texture, &_src, &_dest);
 
 	if (m_animationDelay >= 0.25f)
 	{
 		m_currentFrame++;
-		if (m_currentFrame >= _stickMan.second.size())
+		if (m_currentFrame >= _stickMan.m_frameCount)
 			m_currentFrame = 0;
 		m_animationDelay = 0;
 	}
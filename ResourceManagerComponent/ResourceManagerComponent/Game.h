@@ -32,15 +32,25 @@ private:
 	float					m_animationDelay;
 	bool					m_quit;								// Boolean to quit out of the game
 	bool					m_filesLoaded;
+	LoadHandle				m_loadHandle;						// Progress of the load running in the background
 
-	Mix_Music*				m_gameMusic = nullptr;
-	Mix_Chunk*				m_jump = nullptr;
-	Mix_Chunk*				m_land = nullptr;
+	ResourceHandle			m_gameMusic = INVALID_HANDLE;		// Handles are resolved once per manifest, not per frame
+	ResourceHandle			m_jump = INVALID_HANDLE;
+	ResourceHandle			m_land = INVALID_HANDLE;
+	ResourceHandle			m_playerSprite = INVALID_HANDLE;
+	ResourceHandle			m_bobSprite = INVALID_HANDLE;
+	ResourceHandle			m_bobAnimation = INVALID_HANDLE;
+	ResourceHandle			m_stickManAnimation = INVALID_HANDLE;
 
 	void					update();							// Standard update
 	void					render();							// Standard render
 	void					processInput();						// Gets the user input
+	void					setupResourceManager();				// Gets and configures the resource manager
 	void					renderSprite();
 	void					renderAnimation();
+	void					updateLoading();					// Tracks a background load until it completes
+	void					renderLoadingScreen();
+	void					resolveHandles();					// Looks up the handles of every resource the game draws or plays
+	void					printMemoryStats();					// Logs what the resource manager holds in memory
 };
 
@@ -0,0 +1,141 @@
+#include "stdafx.h"
+#include "Hash.h"
+#include <string.h>
+
+namespace
+{
+	// built during static initialisation so loader threads can share it
+	struct Crc32Table
+	{
+		Crc32Table()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t _value = i;
+				for (int j = 0; j < 8; j++)
+					_value = (_value & 1) ? 0xEDB88320u ^ (_value >> 1) : _value >> 1;
+				m_values[i] = _value;
+			}
+		}
+
+		uint32_t m_values[256];
+	};
+
+	const Crc32Table g_crc32Table;
+
+	const uint64_t XXH_PRIME_1 = 11400714785074694791ull;
+	const uint64_t XXH_PRIME_2 = 14029467366897019727ull;
+	const uint64_t XXH_PRIME_3 = 1609587929392839161ull;
+	const uint64_t XXH_PRIME_4 = 9650029242287828579ull;
+	const uint64_t XXH_PRIME_5 = 2870177450012600261ull;
+
+	inline uint64_t rotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	// unaligned little endian reads, memcpy compiles down to a plain load
+	inline uint64_t read64(const unsigned char* bytes)
+	{
+		uint64_t _value;
+		memcpy(&_value, bytes, sizeof(_value));
+		return _value;
+	}
+
+	inline uint32_t read32(const unsigned char* bytes)
+	{
+		uint32_t _value;
+		memcpy(&_value, bytes, sizeof(_value));
+		return _value;
+	}
+
+	inline uint64_t xxhRound(uint64_t accumulator, uint64_t input)
+	{
+		accumulator += input * XXH_PRIME_2;
+		return rotateLeft(accumulator, 31) * XXH_PRIME_1;
+	}
+
+	inline uint64_t xxhMerge(uint64_t hash, uint64_t accumulator)
+	{
+		hash ^= xxhRound(0, accumulator);
+		return hash * XXH_PRIME_1 + XXH_PRIME_4;
+	}
+}
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc)
+{
+	const unsigned char* _bytes = (const unsigned char*)data;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = g_crc32Table.m_values[(crc ^ _bytes[i]) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash)
+{
+	const unsigned char* _bytes = (const unsigned char*)data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= _bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+
+uint64_t xxhash64(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* _bytes = (const unsigned char*)data;
+	const unsigned char* _end = _bytes + size;
+	uint64_t _hash;
+
+	if (size >= 32)
+	{
+		// four independent lanes keep the multiplier busy
+		uint64_t _v1 = seed + XXH_PRIME_1 + XXH_PRIME_2;
+		uint64_t _v2 = seed + XXH_PRIME_2;
+		uint64_t _v3 = seed;
+		uint64_t _v4 = seed - XXH_PRIME_1;
+
+		for (; _bytes + 32 <= _end; _bytes += 32)
+		{
+			_v1 = xxhRound(_v1, read64(_bytes));
+			_v2 = xxhRound(_v2, read64(_bytes + 8));
+			_v3 = xxhRound(_v3, read64(_bytes + 16));
+			_v4 = xxhRound(_v4, read64(_bytes + 24));
+		}
+
+		_hash = rotateLeft(_v1, 1) + rotateLeft(_v2, 7) + rotateLeft(_v3, 12) + rotateLeft(_v4, 18);
+		_hash = xxhMerge(_hash, _v1);
+		_hash = xxhMerge(_hash, _v2);
+		_hash = xxhMerge(_hash, _v3);
+		_hash = xxhMerge(_hash, _v4);
+	}
+	else
+		_hash = seed + XXH_PRIME_5;
+
+	_hash += size;
+
+	for (; _bytes + 8 <= _end; _bytes += 8)
+		_hash = rotateLeft(_hash ^ xxhRound(0, read64(_bytes)), 27) * XXH_PRIME_1 + XXH_PRIME_4;
+
+	if (_bytes + 4 <= _end)
+	{
+		_hash = rotateLeft(_hash ^ (read32(_bytes) * XXH_PRIME_1), 23) * XXH_PRIME_2 + XXH_PRIME_3;
+		_bytes += 4;
+	}
+
+	for (; _bytes < _end; _bytes++)
+		_hash = rotateLeft(_hash ^ (*_bytes * XXH_PRIME_5), 11) * XXH_PRIME_1;
+
+	_hash ^= _hash >> 33;
+	_hash *= XXH_PRIME_2;
+	_hash ^= _hash >> 29;
+	_hash *= XXH_PRIME_3;
+	_hash ^= _hash >> 32;
+	return _hash;
+}
\ No newline at end of file
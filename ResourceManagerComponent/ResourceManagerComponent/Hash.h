@@ -0,0 +1,16 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32 (IEEE 802.3), used to checksum packed asset data
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
+
+// 64 bit FNV-1a, used to key cached data by content
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64_t FNV_PRIME = 1099511628211ull;
+
+uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS);
+
+
+// 64 bit xxHash, several times faster than the byte at a time hashes above, used to compare file contents
+uint64_t xxhash64(const void* data, size_t size, uint64_t seed = 0);
\ No newline at end of file
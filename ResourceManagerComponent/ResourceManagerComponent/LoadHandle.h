@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+// Tracks one asynchronous load started by the ResourceManager.
+// Workers bump the decoded count, the main thread bumps the loaded count
+// when it registers each resource in ResourceManager::update.
+class LoadProgress
+{
+public:
+	LoadProgress(unsigned int total, unsigned int criticalTotal = 0) :
+		m_total(total), m_criticalTotal(criticalTotal), m_decoded(0), m_loaded(0), m_criticalLoaded(0) {}
+
+	unsigned int getTotal() const { return m_total; }
+	unsigned int getDecoded() const { return m_decoded; }
+	unsigned int getLoaded() const { return m_loaded; }
+
+	float getProgress() const { return m_total == 0 ? 1.0f : (float)m_loaded / m_total; }
+	bool isComplete() const { return m_loaded >= m_total; }
+	bool isCriticalComplete() const { return m_criticalLoaded >= m_criticalTotal; }	// Enough is loaded to show the first frame
+
+	bool hasErrors() const
+	{
+		lock_guard<mutex> _lock(m_errorMutex);
+		return !m_errors.empty();
+	}
+
+	vector<string> getErrors() const
+	{
+		lock_guard<mutex> _lock(m_errorMutex);
+		return m_errors;
+	}
+
+	void markDecoded() { m_decoded++; }
+
+	void markLoaded(const string& error, bool critical = false)
+	{
+		if (!error.empty())
+		{
+			lock_guard<mutex> _lock(m_errorMutex);
+			m_errors.push_back(error);
+		}
+		if (critical)
+			m_criticalLoaded++;
+		m_loaded++;
+	}
+
+private:
+	unsigned int			m_total;
+	unsigned int			m_criticalTotal;
+	atomic<unsigned int>	m_decoded;
+	atomic<unsigned int>	m_loaded;
+	atomic<unsigned int>	m_criticalLoaded;
+
+	mutable mutex			m_errorMutex;
+	vector<string>			m_errors;
+};
+
+typedef shared_ptr<LoadProgress> LoadHandle;
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "ManifestArena.h"
+#include <algorithm>
+
+// The parsers need a few bytes of state for every byte of manifest
+const size_t MANIFEST_ARENA_RATIO = 8;
+const size_t MANIFEST_ARENA_MIN_SIZE = 64 * 1024;
+const size_t MANIFEST_ARENA_ALIGNMENT = 16;
+
+// Of the bytes handed to a JSON parse, per byte of manifest
+const size_t JSON_VALUE_POOL_RATIO = 4;
+const size_t JSON_STACK_POOL_RATIO = 2;
+const size_t JSON_POOL_MIN_SIZE = 1024;
+const size_t JSON_STACK_CAPACITY = 1024;
+
+ManifestArena* ManifestArena::s_attached = nullptr;
+
+ManifestArena::ManifestArena() :
+m_used(0),
+m_overflowSize(0)
+{}
+
+bool ManifestArena::readFile(const string& path)
+{
+	FILE* _file = nullptr;
+	if (fopen_s(&_file, path.c_str(), "rb") != 0 || !_file)
+		return false;
+
+	// ftell fails with -1 on a stream it cannot measure, which would become a huge size below
+	long _size = -1;
+	if (fseek(_file, 0, SEEK_END) == 0)
+		_size = ftell(_file);
+
+	if (_size < 0 || fseek(_file, 0, SEEK_SET) != 0)
+	{
+		fclose(_file);
+		return false;
+	}
+
+	// resize keeps the old capacity, so a manifest no bigger than the last one reuses it
+	m_text.resize((size_t)_size + 1);
+	size_t _read = fread(m_text.data(), 1, (size_t)_size, _file);
+	fclose(_file);
+	m_text[_read] = '\0';
+	m_text.resize(_read + 1);
+
+	// grow to whatever the last parse spilled into overflow, so the next one fits
+	size_t _wanted = max(max(_read * MANIFEST_ARENA_RATIO, MANIFEST_ARENA_MIN_SIZE), m_used + m_overflowSize);
+	if (m_block.size() < _wanted)
+		m_block.resize(_wanted);
+
+	m_overflow.clear();
+	m_overflowSize = 0;
+	m_used = 0;
+	return true;
+}
+
+char* ManifestArena::getText()
+{
+	return m_text.data();
+}
+
+size_t ManifestArena::getTextSize() const
+{
+	return m_text.empty() ? 0 : m_text.size() - 1;
+}
+
+void* ManifestArena::allocate(size_t size)
+{
+	size_t _start = (m_used + MANIFEST_ARENA_ALIGNMENT - 1) & ~(MANIFEST_ARENA_ALIGNMENT - 1);
+	if (_start + size <= m_block.size())
+	{
+		m_used = _start + size;
+		return m_block.data() + _start;
+	}
+
+	m_overflow.push_back(unique_ptr<char[]>(new char[size]));
+	m_overflowSize += size;
+	return m_overflow.back().get();
+}
+
+// rapidxml's allocator hooks take no context, so the arena in use is kept
+// here. Manifests are only parsed on the main thread.
+void ManifestArena::attach(rapidxml::memory_pool<>* pool)
+{
+	s_attached = this;
+	pool->set_allocator(&ManifestArena::allocateXml, &ManifestArena::freeXml);
+}
+
+void* ManifestArena::allocateXml(size_t size)
+{
+	return s_attached->allocate(size);
+}
+
+void ManifestArena::freeXml(void*)
+{
+	// released all at once by the next readFile
+}
+
+JsonManifest::JsonManifest(ManifestArena* arena) :
+m_values(arena->allocate(arena->getTextSize() * JSON_VALUE_POOL_RATIO + JSON_POOL_MIN_SIZE),
+	arena->getTextSize() * JSON_VALUE_POOL_RATIO + JSON_POOL_MIN_SIZE),
+m_stack(arena->allocate(arena->getTextSize() * JSON_STACK_POOL_RATIO + JSON_POOL_MIN_SIZE),
+	arena->getTextSize() * JSON_STACK_POOL_RATIO + JSON_POOL_MIN_SIZE),
+m_document(&m_values, JSON_STACK_CAPACITY, &m_stack)
+{
+	m_document.ParseInsitu(arena->getText());
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <rapidjson\document.h>
+#include "rapidxml.hpp"
+
+using namespace std;
+
+// Reusable memory for parsing manifests. The file is read into a buffer that
+// both parsers work on in place, and every parser allocation is carved out
+// of one block sized from the file. Both buffers are kept between parses, so
+// reloading a manifest stops touching the heap once they have grown to fit.
+class ManifestArena
+{
+public:
+	ManifestArena();
+
+	bool									readFile(const string& path);	// Also frees everything allocated since the last read
+	char*									getText();
+	size_t									getTextSize() const;
+
+	void*									allocate(size_t size);
+	void									attach(rapidxml::memory_pool<>* pool);	// Makes pool allocate from this arena
+
+private:
+	vector<char>							m_text;
+	vector<char>							m_block;
+	size_t									m_used;
+	vector<unique_ptr<char[]>>				m_overflow;			// Allocations the block had no room for
+	size_t									m_overflowSize;
+
+	static ManifestArena*					s_attached;
+
+	static void*							allocateXml(size_t size);
+	static void								freeXml(void* memory);
+};
+
+typedef rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>, rapidjson::MemoryPoolAllocator<>> ManifestDocument;
+
+// A JSON manifest parsed in place from the text of a ManifestArena, with its
+// values and the parser's stack both in pools taken from the arena
+struct JsonManifest
+{
+	JsonManifest(ManifestArena* arena);
+
+	rapidjson::MemoryPoolAllocator<>		m_values;
+	rapidjson::MemoryPoolAllocator<>		m_stack;
+	ManifestDocument						m_document;
+};
\ No newline at end of file
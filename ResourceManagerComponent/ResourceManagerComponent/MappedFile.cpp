@@ -0,0 +1,157 @@
+#include "stdafx.h"
+#include "MappedFile.h"
+
+#if defined(_WIN64) || defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+m_data(nullptr),
+m_size(0),
+m_open(false)
+#if defined(_WIN64) || defined(_WIN32)
+, m_file(INVALID_HANDLE_VALUE),
+m_mapping(NULL)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#if defined(_WIN64) || defined(_WIN32)
+
+bool MappedFile::open(const string& path)
+{
+	close();
+
+	m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER _size;
+	if (!GetFileSizeEx(m_file, &_size))
+	{
+		close();
+		return false;
+	}
+
+	m_size = (size_t)_size.QuadPart;
+	m_open = true;
+
+	// an empty file cannot be mapped but is still a valid file
+	if (m_size == 0)
+		return true;
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL)
+	{
+		close();
+		return false;
+	}
+
+	m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_data == NULL)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_data = nullptr;
+	m_mapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+	m_size = 0;
+	m_open = false;
+}
+
+#else
+
+bool MappedFile::open(const string& path)
+{
+	close();
+
+	int _descriptor = ::open(path.c_str(), O_RDONLY);
+	if (_descriptor < 0)
+		return false;
+
+	struct stat _result;
+	if (fstat(_descriptor, &_result) != 0)
+	{
+		::close(_descriptor);
+		return false;
+	}
+
+	m_size = (size_t)_result.st_size;
+	m_open = true;
+
+	if (m_size > 0)
+	{
+		void* _data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, _descriptor, 0);
+		if (_data == MAP_FAILED)
+		{
+			::close(_descriptor);
+			m_size = 0;
+			m_open = false;
+			return false;
+		}
+
+		// decoders read front to back
+		madvise(_data, m_size, MADV_SEQUENTIAL);
+		m_data = (const unsigned char*)_data;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	::close(_descriptor);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+		munmap((void*)m_data, m_size);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return m_open;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+	return m_data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return m_size;
+}
+
+SDL_RWops* MappedFile::createRWops() const
+{
+	return SDL_RWFromConstMem(m_data, (int)m_size);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include "SDL_rwops.h"
+
+using namespace std;
+
+// A read-only view of a whole file mapped into memory.
+// Decoders read straight from the mapping through an SDL_RWops, so the file
+// is opened once and never copied into an intermediate buffer.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool									open(const string& path);
+	void									close();
+
+	bool									isOpen() const;
+	const unsigned char*					getData() const;
+	size_t									getSize() const;
+
+	SDL_RWops*								createRWops() const;	// Caller owns the returned view
+
+private:
+	const unsigned char*					m_data;
+	size_t									m_size;
+	bool									m_open;
+
+#if defined(_WIN64) || defined(_WIN32)
+	void*									m_file;
+	void*									m_mapping;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile&								operator=(const MappedFile&);
+};
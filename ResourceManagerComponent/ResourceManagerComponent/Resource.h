@@ -4,35 +4,44 @@
 
 using namespace std;
 
-struct Resource
+// Lower values are loaded first
+enum ResourcePriority
 {
-public:
-	Resource(string key) : m_key(key){}
-
-	virtual string getKey(){ return m_key; }
-
-protected:
-	string m_key;
-
+	PRIORITY_CRITICAL,
+	PRIORITY_HIGH,
+	PRIORITY_NORMAL,
+	PRIORITY_LOW,
+	PRIORITY_BACKGROUND
 };
 
-struct Texture : Resource
+inline ResourcePriority parsePriority(const string& name)
 {
-	Texture(string key, string textureDir) : Resource(key), m_textureDir(textureDir) {}
-
-	string m_textureDir;
-};
-
-struct Music : Resource
+	if (name == "critical")
+		return PRIORITY_CRITICAL;
+	else if (name == "high")
+		return PRIORITY_HIGH;
+	else if (name == "low")
+		return PRIORITY_LOW;
+	else if (name == "background")
+		return PRIORITY_BACKGROUND;
+	else
+		return PRIORITY_NORMAL;
+}
+
+enum ResourceType
 {
-	Music(string key, string musicDir) : Resource(key), m_musicDir(musicDir) {}
-
-	string m_musicDir;
+	RESOURCE_TEXTURE,
+	RESOURCE_MUSIC,
+	RESOURCE_SOUND_EFFECT
 };
 
-struct SoundEffect : Resource
+// One queued resource. Descriptors are plain values stored back to back in the
+// ResourceManager's queue, and their strings live in its StringArena, so a
+// queued resource is not a heap object of its own and needs no RTTI to be loaded.
+struct Resource
 {
-	SoundEffect(string key, string soundEffectDir) : Resource(key), m_soundEffectDir(soundEffectDir) {}
-
-	string m_soundEffectDir;
-};
+	const char*			m_key;
+	const char*			m_path;
+	ResourceType		m_type;
+	ResourcePriority	m_priority;
+};
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include "Hash.h"
+
+using namespace std;
+
+// FNV-1a over a string literal, evaluated by the compiler.
+// Gives the same value as fnv1a64() over the same characters.
+constexpr uint64_t hashResourceKey(const char* key, size_t length, uint64_t hash = FNV_OFFSET_BASIS)
+{
+	return length == 0 ? hash : hashResourceKey(key + 1, length - 1, (hash ^ (unsigned char)*key) * FNV_PRIME);
+}
+
+// A resource key reduced to its 64 bit hash, so looking one up never hashes or allocates
+struct ResourceKey
+{
+	constexpr explicit ResourceKey(uint64_t hash) : m_hash(hash) {}
+	explicit ResourceKey(const string& key) : m_hash(fnv1a64(key.data(), key.size())) {}
+	ResourceKey(const char* key, size_t length) : m_hash(fnv1a64(key, length)) {}
+
+	uint64_t	m_hash;
+};
+
+constexpr ResourceKey operator"" _rk(const char* key, size_t length)
+{
+	return ResourceKey(hashResourceKey(key, length));
+}
\ No newline at end of file
@@ -4,37 +4,64 @@
 ResourceManager * ResourceManager::m_instance = nullptr;
 
 const int MAX_DELAY = 3;
+const int IMG_FLAGS = IMG_INIT_PNG | IMG_INIT_JPG;
+const int MIX_FLAGS = MIX_INIT_OGG;
 
-ResourceManager::~ResourceManager()
+// Identifies one slot of one resource type
+inline uint64_t getSlotId(ResourceType type, ResourceHandle handle)
+{
+	return ((uint64_t)type << 32) | handle;
+}
+
+inline bool isChunkPlaying(Mix_Chunk* chunk)
 {
-	for (vector<Resource*>::iterator _it = m_resourceQueue.begin(); _it != m_resourceQueue.end(); ++_it)
+	for (int i = 0; i < Mix_AllocateChannels(-1); i++)
 	{
-		Resource* _r = *_it;
-		delete _r;
-		(*_it) = nullptr;
+		if (Mix_Playing(i) && Mix_GetChunk(i) == chunk)
+			return true;
 	}
 
-	for (map<string, pair<SDL_Texture*, tm>>::iterator _it = m_textures.begin(); _it != m_textures.end(); ++_it)
+	return false;
+}
+
+ResourceManager::~ResourceManager()
+{
+	// let any decode that is already running finish, then drop what it produced
+	m_loaderPool.cancelPending();
+	m_loaderPool.wait();
+
+	for (auto& decoded : m_decodedResources)
+		freeDecodedResource(decoded.second.get());
+	m_decodedResources.clear();
+
+	for (vector<TextureEntry>::iterator _it = m_textures.begin(); _it != m_textures.end(); ++_it)
 	{
-		SDL_Texture* _t = (*_it).second.first;
-		SDL_DestroyTexture(_t);
-		(*_it).second.first = NULL;
+		SDL_Texture* _t = (*_it).m_texture;
+		if (_t && !(*_it).m_atlased)
+			SDL_DestroyTexture(_t);
+		(*_it).m_texture = NULL;
 	}
+	m_atlas = nullptr;
 	
-	for (map<string, Mix_Music*>::iterator _it = m_music.begin(); _it != m_music.end(); ++_it)
+	for (vector<MusicEntry>::iterator _it = m_music.begin(); _it != m_music.end(); ++_it)
 	{
-		Mix_Music* _m = (*_it).second;
-		Mix_FreeMusic(_m);
-		(*_it).second = NULL;
+		Mix_Music* _m = (*_it).m_music;
+		if (_m)
+			Mix_FreeMusic(_m);
+		(*_it).m_music = NULL;
+		(*_it).m_file = nullptr;
 	}
 
-	for (map<string, Mix_Chunk*>::iterator _it = m_soundEffects.begin(); _it != m_soundEffects.end(); ++_it)
+	for (vector<SoundEffectEntry>::iterator _it = m_soundEffects.begin(); _it != m_soundEffects.end(); ++_it)
 	{
-		Mix_Chunk* _s = (*_it).second;
-		Mix_FreeChunk(_s);
-		(*_it).second = NULL;
+		Mix_Chunk* _s = (*_it).m_chunk;
+		if (_s)
+			Mix_FreeChunk(_s);
+		(*_it).m_chunk = NULL;
 	}
 
+	freeRetiredAudio(true);
+
 	m_renderer = nullptr;
 
 	Mix_CloseAudio();
@@ -52,6 +79,13 @@ ResourceManager* ResourceManager::getInstance()
 
 void ResourceManager::init(SDL_Renderer* renderer)
 {
+	// the decoders load their codec libraries on first use, which must not happen on several workers at once
+	if ((IMG_Init(IMG_FLAGS) & IMG_FLAGS) != IMG_FLAGS)
+		std::cout << "Error initialising SDL_image: " << IMG_GetError() << std::endl;
+
+	if ((Mix_Init(MIX_FLAGS) & MIX_FLAGS) != MIX_FLAGS)
+		std::cout << "Error initialising SDL_mixer: " << Mix_GetError() << std::endl;
+
 	//Initialize SDL_mixer
 	if (Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 4096) == -1)
 		std::cout << "Error initialising SDL audio!!" << std::endl;
@@ -65,520 +99,2228 @@ void ResourceManager::destroy()
 	m_instance = nullptr;
 }
 
-void ResourceManager::update(float dt)
+void ResourceManager::update()
 {
-	m_fileCheckDelay += dt;
-	if (m_fileCheckDelay >= MAX_DELAY)
+	Uint64 _frameStart = SDL_GetPerformanceCounter();
+	processDecodedResources(_frameStart);
+	processPendingResources(_frameStart);
+
+	//apply the file changes the watcher thread has found, nothing here touches the file system
+	string _path;
+	while (m_watcher.popChange(&_path))
 	{
-		//check underlying file changes
-		for (map<string, pair<SDL_Texture*, tm>>::iterator _it = m_textures.begin(); _it != m_textures.end(); ++_it)
-		{
-			tm _timeInfo = getTimeInfo(m_path[_it->first].c_str());
-			
-			if (isOutOfDate(_it->second.second, _timeInfo))
-				reloadTexture(_it->first);
-		}
+		if (_path == m_source && m_source.find(".pak") == string::npos)
+			reloadManifest();
 
-		tm _fileTimeInfo = getTimeInfo(m_source.c_str());
-		if (isOutOfDate(m_sourceTimeInfo, _fileTimeInfo))
+		vector<pair<ResourceType, ResourceHandle>>* _resources = m_watchedResources.find(_path);
+		if (!_resources)
+			continue;
+
+		for (auto& resource : *_resources)
 		{
-			m_sourceTimeInfo = _fileTimeInfo;
-			if (m_source.find(".xml") != string::npos)
-				reloadFromXML();
-			else if (m_source.find(".json") != string::npos)
-				reloadFromJSON();
-			else if (m_source.find(".txt") != string::npos)
-				reloadFromText();
+			findResidency(resource.first, resource.second)->m_failed = false;
+
+			if (resource.first != RESOURCE_TEXTURE)
+				reloadAudio(resource.first, resource.second);
+			else if (m_textures[resource.second].m_texture)
+			{
+				// a half written or broken file leaves the old texture in place until it is saved again
+				try
+				{
+					reloadTexture(resource.second);
+				}
+				catch (LoadException&)
+				{
+				}
+			}
 		}
-
-		m_fileCheckDelay = 0;
 	}
+
+	freeRetiredAudio(false);
 }
 
-SDL_Texture* ResourceManager::getTextureByKey(string key)
+ResourceHandle ResourceManager::getTextureHandle(const string& key)
 {
-	auto _texture = m_textures.find(key);
+	return lookupHandle(&m_textureHandles, key);
+}
 
-	if (_texture != m_textures.end())
-		return _texture->second.first;
-	else
-		return m_textures["placeholder"].first;
+ResourceHandle ResourceManager::getMusicHandle(const string& key)
+{
+	return lookupHandle(&m_musicHandles, key);
 }
 
-Mix_Music* ResourceManager::getMusicByKey(string key)
+ResourceHandle ResourceManager::getSoundEffectHandle(const string& key)
 {
-	auto _music = m_music.find(key);
+	return lookupHandle(&m_soundEffectHandles, key);
+}
 
-	if (_music != m_music.end())
-		return _music->second;
-	else
-		return m_music["placeholder"];
+ResourceHandle ResourceManager::getAnimationHandle(const string& key)
+{
+	return lookupHandle(&m_animationHandles, key);
 }
 
-Mix_Chunk* ResourceManager::getSoundEffectByKey(string key)
+ResourceHandle ResourceManager::getTextureHandle(ResourceKey key)
 {
-	auto _soundEffect = m_soundEffects.find(key);
+	return lookupHandle(&m_textureHandles, key);
+}
 
-	if (_soundEffect != m_soundEffects.end())
-		return _soundEffect->second;
-	else
-		return m_soundEffects["placeholder"];
+ResourceHandle ResourceManager::getMusicHandle(ResourceKey key)
+{
+	return lookupHandle(&m_musicHandles, key);
 }
 
-pair<SDL_Texture*, vector<SDL_Rect>> ResourceManager::getAnimationByKey(string key)
+ResourceHandle ResourceManager::getSoundEffectHandle(ResourceKey key)
 {
-	pair<SDL_Texture*, vector<SDL_Rect>> _temp;
-	_temp.first = getTextureByKey(key);
-	_temp.second = getAnimationFrames(key);
-	return _temp;
+	return lookupHandle(&m_soundEffectHandles, key);
 }
 
-void ResourceManager::loadResourcesFromText(string fileName)
+ResourceHandle ResourceManager::getAnimationHandle(ResourceKey key)
 {
-	m_source = fileName;
-	m_sourceTimeInfo = getTimeInfo(m_source.c_str());
+	return lookupHandle(&m_animationHandles, key);
+}
 
-	string _key, _path, _type;
-	ifstream _myFile(fileName);
+SDL_Texture* ResourceManager::getTexture(ResourceHandle handle)
+{
+	touch(RESOURCE_TEXTURE, handle);
+	const TextureEntry* _entry = findTextureEntry(handle);
+	return _entry ? _entry->m_texture : nullptr;
+}
+
+Sprite ResourceManager::getSprite(ResourceHandle handle)
+{
+	Sprite _sprite = Sprite();
 
-	while (_myFile >> _type >> _key >> _path)
+	touch(RESOURCE_TEXTURE, handle);
+	const TextureEntry* _entry = findTextureEntry(handle);
+	if (_entry)
 	{
-		if (_type == "texture")
-			addResourceToQueue(new Texture(_key, _path));
-		else if (_type == "music")
-			addResourceToQueue(new Music(_key, _path));
-		else if (_type == "sound_effect")
-			addResourceToQueue(new SoundEffect(_key, _path));
-		else
-		{
-			addResourceToQueue(new Texture(_key, _path));
+		_sprite.m_texture = _entry->m_texture;
+		_sprite.m_source = _entry->m_source;
+	}
 
-			string _line;
-			_myFile >> _line;
+	return _sprite;
+}
 
-			vector<SDL_Rect> _animationList;
+Mix_Music* ResourceManager::getMusic(ResourceHandle handle)
+{
+	touch(RESOURCE_MUSIC, handle);
+	if (handle < m_music.size() && m_music[handle].m_music)
+		return m_music[handle].m_music;
+	else if (m_musicHandles.m_placeholder < m_music.size())
+		return m_music[m_musicHandles.m_placeholder].m_music;
+	else
+		return nullptr;
+}
 
-			int _frames = stoi(_line);
-			for (int i = 1; i <= _frames; i++)
-				loadAnimations(&_myFile, &_animationList);
+Mix_Chunk* ResourceManager::getSoundEffect(ResourceHandle handle)
+{
+	touch(RESOURCE_SOUND_EFFECT, handle);
+	if (handle < m_soundEffects.size() && m_soundEffects[handle].m_chunk)
+		return m_soundEffects[handle].m_chunk;
+	else if (m_soundEffectHandles.m_placeholder < m_soundEffects.size())
+		return m_soundEffects[m_soundEffectHandles.m_placeholder].m_chunk;
+	else
+		return nullptr;
+}
 
-			m_animations[_key] = _animationList;
-		}
+AnimationClip ResourceManager::getAnimation(ResourceHandle handle)
+{
+	if (handle >= m_animations.size())
+		handle = m_animationHandles.m_placeholder;
+
+	AnimationClip _clip = AnimationClip();
+	if (handle >= m_animations.size())
+	{
+		_clip.m_texture = getTexture(INVALID_HANDLE);
+		return _clip;
 	}
 
-	_myFile.close();
+	const AnimationEntry& _entry = m_animations[handle];
+	_clip.m_texture = getTexture(_entry.m_texture);
+	_clip.m_frames = m_frameArena.data() + _entry.m_firstFrame;
+	_clip.m_frameCount = _entry.m_frameCount;
+	return _clip;
 }
 
-void ResourceManager::loadResourcesFromJSON(string fileName)
+SDL_Texture* ResourceManager::getTextureByKey(const string& key)
 {
-	m_source = fileName;
-	m_sourceTimeInfo = getTimeInfo(m_source.c_str());
+	return getTexture(getTextureHandle(key));
+}
 
-	FILE* _file = new FILE();
-	fopen_s(&_file, fileName.c_str(), "rb");
-	char readBuffer[65536];
-	FileReadStream _is(_file, readBuffer, sizeof(readBuffer));
-	Document _document;
-	_document.ParseStream(_is);
-	fclose(_file);
+Sprite ResourceManager::getSpriteByKey(const string& key)
+{
+	return getSprite(getTextureHandle(key));
+}
 
-	const Value& _resources = _document["resources"];
+Mix_Music* ResourceManager::getMusicByKey(const string& key)
+{
+	return getMusic(getMusicHandle(key));
+}
 
-	const Value& _textures = _resources["textures"];
-	for (Value::ConstMemberIterator _it = _textures.MemberBegin(); _it != _textures.MemberEnd(); ++_it)
-	{
-		string name = _it->name.GetString();
-		const Value& _t = _textures[name.c_str()];
+Mix_Chunk* ResourceManager::getSoundEffectByKey(const string& key)
+{
+	return getSoundEffect(getSoundEffectHandle(key));
+}
 
-		checkJsonObject(_t, "texture");
-	}
+AnimationClip ResourceManager::getAnimationByKey(const string& key)
+{
+	ResourceHandle _animation = findHandle(m_animationHandles, key);
+	if (_animation != INVALID_HANDLE)
+		return getAnimation(_animation);
+
+	// a plain texture drawn through the animation path has no frames of its own
+	AnimationClip _clip = getAnimation(INVALID_HANDLE);
+	_clip.m_texture = getTextureByKey(key);
+	return _clip;
+}
 
-	const Value& _music = _resources["music"];
-	for (Value::ConstMemberIterator _it = _music.MemberBegin(); _it != _music.MemberEnd(); ++_it)
-	{
-		string name = _it->name.GetString();
-		const Value& _m = _music[name.c_str()];
+SDL_Texture* ResourceManager::getTextureByKey(ResourceKey key)
+{
+	return getTexture(getTextureHandle(key));
+}
 
-		checkJsonObject(_m, "music");
-	}
+Sprite ResourceManager::getSpriteByKey(ResourceKey key)
+{
+	return getSprite(getTextureHandle(key));
+}
 
-	const Value& _effects = _resources["effects"];
-	for (Value::ConstMemberIterator _it = _effects.MemberBegin(); _it != _effects.MemberEnd(); ++_it)
-	{
-		string name = _it->name.GetString();
-		const Value& _e = _effects[name.c_str()];
+Mix_Music* ResourceManager::getMusicByKey(ResourceKey key)
+{
+	return getMusic(getMusicHandle(key));
+}
 
-		checkJsonObject(_e, "effect");
-	}
+Mix_Chunk* ResourceManager::getSoundEffectByKey(ResourceKey key)
+{
+	return getSoundEffect(getSoundEffectHandle(key));
+}
 
-	const Value& _animations = _resources["animations"];
-	for (Value::ConstMemberIterator _it = _animations.MemberBegin(); _it != _animations.MemberEnd(); ++_it)
-	{
-		string name = _it->name.GetString();
-		const Value& _a = _animations[name.c_str()];
+AnimationClip ResourceManager::getAnimationByKey(ResourceKey key)
+{
+	ResourceHandle _animation = findHandle(m_animationHandles, key);
+	if (_animation != INVALID_HANDLE)
+		return getAnimation(_animation);
 
-		checkJsonObject(_a, "animation");
-	}
+	AnimationClip _clip = getAnimation(INVALID_HANDLE);
+	_clip.m_texture = getTextureByKey(key);
+	return _clip;
 }
 
-void ResourceManager::loadResourcesFromXML(string fileName)
+void ResourceManager::loadResourcesFromText(string fileName)
 {
 	m_source = fileName;
-	m_sourceTimeInfo = getTimeInfo(m_source.c_str());
+	m_watcher.watch(m_source);
 
-	string _line;
 	ifstream _myFile(fileName);
 
-	xml_document<> _document;
-	std::stringstream _buffer;
-	_buffer << _myFile.rdbuf();
+	ManifestRecord _record;
+	while (readTextRecord(&_myFile, &_record))
+		addManifestRecord(_record);
+
 	_myFile.close();
-	std::string content(_buffer.str());
-	_document.parse<0>(&content[0]);
+}
 
-	xml_node<>* _root = _document.first_node();
+void ResourceManager::loadResourcesFromJSON(string fileName)
+{
+	m_source = fileName;
+	m_watcher.watch(m_source);
+
+	vector<ManifestRecord> _records;
+	if (!readJsonRecords(fileName, &_records))
+		throw(LoadException("Could not read manifest " + fileName + "\n"));
+
+	for (auto& record : _records)
+		addManifestRecord(record);
+}
+
+void ResourceManager::loadResourcesFromXML(string fileName)
+{
+	m_source = fileName;
+	m_watcher.watch(m_source);
 
-	xml_node<>* _assets = _root->first_node("textures");
+	vector<ManifestRecord> _records;
+	if (!readXmlRecords(fileName, &_records))
+		throw(LoadException("Could not read manifest " + fileName + "\n"));
 
-	xml_node<>* _texture = _assets->first_node("texture");
-	while (_texture != 0)
+	for (auto& record : _records)
+		addManifestRecord(record);
+}
+
+void ResourceManager::loadResourcesFromPack(string fileName)
+{
+	m_source = fileName;
+	m_watcher.watch(m_source);
+
+	shared_ptr<ResourcePack> _pack = make_shared<ResourcePack>();
+	if (!_pack->open(fileName))
+		throw(LoadException("Could not open resource pack " + fileName + ", it is missing, truncated or corrupt\n"));
+
+	m_pack = _pack;
+
+	for (unsigned int i = 0; i < m_pack->getEntryCount(); i++)
 	{
-		string _key = _texture->first_node("key")->value();
-		string _path = _texture->first_node("path")->value();
-		addResourceToQueue(new Texture(_key, _path));
-		_texture = _texture->next_sibling();
+		const PackEntry* _entry = m_pack->getEntry(i);
+		string _key = m_pack->getString(_entry->m_keyOffset);
+		string _path = m_pack->getString(_entry->m_pathOffset);
+		ResourcePriority _priority = (ResourcePriority)_entry->m_priority;
+
+		switch (_entry->m_type)
+		{
+		case PACK_TEXTURE:
+			addResourceToQueue(RESOURCE_TEXTURE, _key, _path, _priority);
+			break;
+		case PACK_MUSIC:
+			addResourceToQueue(RESOURCE_MUSIC, _key, _path, _priority);
+			break;
+		case PACK_SOUND_EFFECT:
+			addResourceToQueue(RESOURCE_SOUND_EFFECT, _key, _path, _priority);
+			break;
+		case PACK_FRAMES:
+		{
+			if (!m_pack->verify(_entry))
+				throw(LoadException("Checksum mismatch for " + _key + " frames in resource pack " + fileName + "\n"));
+
+			const int32_t* _values = (const int32_t*)m_pack->getData(_entry);
+			vector<SDL_Rect> _animationList((size_t)(_entry->m_size / sizeof(SDL_Rect)));
+
+			for (size_t j = 0; j < _animationList.size(); j++)
+			{
+				_animationList[j].x = _values[j * 4];
+				_animationList[j].y = _values[j * 4 + 1];
+				_animationList[j].w = _values[j * 4 + 2];
+				_animationList[j].h = _values[j * 4 + 3];
+			}
+
+			setAnimationFrames(_key, _animationList);
+			break;
+		}
+		}
 	}
+}
+
+void ResourceManager::loadResourcesFromBinary(string fileName)
+{
+	m_source = fileName;
+	m_watcher.watch(m_source);
 
-	_assets = _assets->next_sibling();
-	xml_node<>* _music = _assets->first_node("music");
-	while (_music != 0)
+	BinaryManifest _manifest;
+	if (!_manifest.open(fileName))
+		throw(LoadException("Could not open compiled manifest " + fileName + "\n"));
+
+	for (unsigned int i = 0; i < _manifest.getEntryCount(); i++)
 	{
-		string _key = _music->first_node("key")->value();
-		string _path = _music->first_node("path")->value();
-		addResourceToQueue(new Music(_key, _path));
-		_music = _music->next_sibling();
+		const ManifestEntry* _entry = _manifest.getEntry(i);
+		const char* _key = _manifest.getString(_entry->m_keyOffset);
+		const char* _path = _manifest.getString(_entry->m_pathOffset);
+		ResourcePriority _priority = (ResourcePriority)_entry->m_priority;
+
+		switch (_entry->m_type)
+		{
+		case MANIFEST_TEXTURE:
+			addResourceToQueue(RESOURCE_TEXTURE, _key, _path, _priority);
+			break;
+		case MANIFEST_MUSIC:
+			addResourceToQueue(RESOURCE_MUSIC, _key, _path, _priority);
+			break;
+		case MANIFEST_SOUND_EFFECT:
+			addResourceToQueue(RESOURCE_SOUND_EFFECT, _key, _path, _priority);
+			break;
+		case MANIFEST_ANIMATION:
+		{
+			addResourceToQueue(RESOURCE_TEXTURE, _key, _path, _priority);
+
+			setAnimationFrames(_key, _manifest.getFrames(_entry), _entry->m_frameCount);
+			break;
+		}
+		}
 	}
-		
-	_assets = _assets->next_sibling();
-	xml_node<>* _effect = _assets->first_node("effect");
-	while (_effect != 0)
+}
+
+void ResourceManager::loadResourcesFromManifest(string fileName)
+{
+	if (fileName.find(".xml") != string::npos)
+		loadResourcesFromXML(fileName);
+	else if (fileName.find(".json") != string::npos)
+		loadResourcesFromJSON(fileName);
+	else if (fileName.find(".pak") != string::npos)
+		loadResourcesFromPack(fileName);
+	else if (fileName.find(".rman") != string::npos)
+		loadResourcesFromBinary(fileName);
+	else
+		loadResourcesFromText(fileName);
+}
+
+bool ResourceManager::buildPack(string manifestFile, string packFile)
+{
+	loadResourcesFromManifest(manifestFile);
+
+	vector<PackSource> _sources;
+	for (auto& resource : m_resourceQueue)
 	{
-		string _key = _effect->first_node("key")->value();
-		string _path = _effect->first_node("path")->value();
-		addResourceToQueue(new SoundEffect(_key, _path));
-		_effect = _effect->next_sibling();
+		PackSource _source;
+		_source.m_key = resource.m_key;
+		_source.m_path = resource.m_path;
+		_source.m_priority = resource.m_priority;
+
+		switch (resource.m_type)
+		{
+		case RESOURCE_TEXTURE:
+			_source.m_type = PACK_TEXTURE;
+			break;
+		case RESOURCE_MUSIC:
+			_source.m_type = PACK_MUSIC;
+			break;
+		case RESOURCE_SOUND_EFFECT:
+			_source.m_type = PACK_SOUND_EFFECT;
+			break;
+		}
+
+		_sources.push_back(_source);
 	}
 
-	_assets = _assets->next_sibling();
-	xml_node<>* _animation = _assets->first_node("animation");
-	while (_animation != 0)
+	for (auto& animation : m_animationHandles.m_names)
 	{
-		string _key = _animation->first_node("key")->value();
-		string _path = _animation->first_node("path")->value();
-		addResourceToQueue(new Texture(_key, _path));
+		PackSource _source;
+		_source.m_key = animation.first;
+		_source.m_type = PACK_FRAMES;
+		_source.m_priority = PRIORITY_NORMAL;
+		_source.m_frames = getAuthoredFrames(animation.second);
 
-		vector<SDL_Rect> _animationList;
-		xml_node<>* _frame = _animation->first_node("metaData")->first_node("frame");
+		_sources.push_back(_source);
+	}
 
-		while (_frame != 0)
-		{
-			SDL_Rect _tempRect = SDL_Rect();
-			_tempRect.w = stoi(_frame->first_node("width")->value());
-			_tempRect.h = stoi(_frame->first_node("height")->value());
-			_tempRect.x = stoi(_frame->first_node("x")->value());
-			_tempRect.y = stoi(_frame->first_node("y")->value());
+	return ResourcePack::build(packFile, _sources);
+}
+
+bool ResourceManager::compileManifest(string manifestFile, string binaryFile)
+{
+	loadResourcesFromManifest(manifestFile);
 
-			_animationList.push_back(_tempRect);
+	vector<ManifestSource> _sources;
+	for (auto& resource : m_resourceQueue)
+	{
+		ManifestSource _source;
+		_source.m_key = resource.m_key;
+		_source.m_path = resource.m_path;
+		_source.m_priority = resource.m_priority;
 
-			_frame = _frame->next_sibling();
+		switch (resource.m_type)
+		{
+		case RESOURCE_TEXTURE:
+		{
+			ResourceHandle _animation = findHandle(m_animationHandles, _source.m_key);
+			if (_animation != INVALID_HANDLE)
+			{
+				_source.m_type = MANIFEST_ANIMATION;
+				_source.m_frames = getAuthoredFrames(_animation);
+			}
+			else
+				_source.m_type = MANIFEST_TEXTURE;
+			break;
+		}
+		case RESOURCE_MUSIC:
+			_source.m_type = MANIFEST_MUSIC;
+			break;
+		case RESOURCE_SOUND_EFFECT:
+			_source.m_type = MANIFEST_SOUND_EFFECT;
+			break;
 		}
 
-		m_animations[_key] = _animationList;
-		_animation = _animation->next_sibling();
+		_sources.push_back(_source);
 	}
+
+	return BinaryManifest::build(binaryFile, _sources);
 }
 
 void ResourceManager::loadResourceQueue()
 {
-	cout << "Number of resources to load: " + to_string(m_resourceQueue.size()) << endl;
+	vector<Resource> _schedule = getScheduledQueue();
+
+	cout << "Number of resources to load: " + to_string(_schedule.size()) << endl;
 	cout << "Loading... 0%" << endl << endl;
-	for (auto& resource : m_resourceQueue)
-		loadResource(resource);
-}
 
-void ResourceManager::addResourceToQueue(Resource* resource)
-{
-	Texture* _textureResource = dynamic_cast<Texture*>(resource);
-	Music* _musicResource = dynamic_cast<Music*>(resource);
-	SoundEffect* _soundEffectResource = dynamic_cast<SoundEffect*>(resource);
+	Uint64 _start = SDL_GetPerformanceCounter();
 
-	if (_textureResource)
-		m_path[_textureResource->getKey()] = _textureResource->m_textureDir.c_str();
-	else if (_musicResource)
-		m_path[_musicResource->getKey()] = _musicResource->m_musicDir.c_str();
-	else
-		m_path[_soundEffectResource->getKey()] = _soundEffectResource->m_soundEffectDir.c_str();
+	// read and decode every file on the worker threads, most important first
+	vector<DecodedResource> _decoded(_schedule.size());
+	for (size_t i = 0; i < _schedule.size(); i++)
+	{
+		DecodedResource* _d = &_decoded[i];
+		_d->resource = _schedule[i];
+		m_loaderPool.enqueue([this, _d]() { decodeResource(_d); });
+	}
+	m_loaderPool.wait();
 
-	m_resourceQueue.push_back(resource);
-}
+	// textures can only be created on the thread that owns the renderer
+	string _error;
+	for (auto& decoded : _decoded)
+	{
+		string _failure = decoded.error;
+		if (_failure.empty())
+		{
+			try
+			{
+				loadResource(&decoded);
+			}
+			catch (LoadException&)
+			{
+				_failure = string("Could not load ") + decoded.resource.m_key;
+			}
+		}
 
-void ResourceManager::loadResource(Resource* resource)
-{
-	Texture* _textureResource = dynamic_cast<Texture*>(resource);
-	Music* _musicResource = dynamic_cast<Music*>(resource);
-	SoundEffect* _soundEffectResource = dynamic_cast<SoundEffect*>(resource);
+		if (_failure.empty())
+			continue;
 
-	m_resourcesLoaded++;
+		abandonDecode(decoded.resource);
+		if (_error.empty())
+			_error = _failure;
+	}
 
-	if (_textureResource)
-		addTexture(_textureResource->getKey());
-	else if (_musicResource)
-		addMusic(_musicResource->getKey());
-	else
-		addSoundEffect(_soundEffectResource->getKey());
+	double _elapsed = (double)(SDL_GetPerformanceCounter() - _start) / SDL_GetPerformanceFrequency();
+	cout << "Loaded " + to_string(_schedule.size()) + " resources on " + to_string(m_loaderPool.getThreadCount()) +
+		" threads in " + to_string(_elapsed * 1000.0) + "ms" << endl << endl;
 
-	float _percentage = m_resourcesLoaded / m_resourceQueue.size();
-	cout << "Current Resource: " + resource->getKey() << endl;
-	cout << "Loading... " + to_string(_percentage) + "%" << endl << endl;
+	if (!_error.empty())
+		throw(LoadException(_error));
 }
 
-void ResourceManager::addTexture(string key)
+LoadHandle ResourceManager::loadResourceQueueAsync()
 {
-	SDL_Texture* _temp = nullptr;
+	vector<Resource> _schedule = getScheduledQueue();
 
-	if (!doesFileExists(m_path[key]))
-		throw(LoadException("Could not load texture " + key + " from " + m_path[key]));
+	cout << "Number of resources to load in the background: " + to_string(_schedule.size()) << endl << endl;
+	LoadHandle _handle = createLoadHandle(_schedule);
 
-	_temp = IMG_LoadTexture(m_renderer, m_path[key].c_str());
-	if (_temp == 0)
-		throw(LoadException("Could not load texture " + key + " from " + m_path[key] + "\n" + IMG_GetError() + "\n"));
+	for (auto& resource : _schedule)
+		enqueueDecode(_handle, resource);
 
-	m_textures[key].first = _temp;
-	m_textures[key].second = getTimeInfo(m_path[key].c_str());
+	return _handle;
 }
 
-void ResourceManager::addMusic(string key)
+LoadHandle ResourceManager::loadResourceQueueIncremental()
 {
-	Mix_Music* _temp = nullptr;
+	vector<Resource> _schedule = getScheduledQueue();
 
-	if (!doesFileExists(m_path[key].c_str()))
-		throw(LoadException("Could not load music " + key + " from " + m_path[key]));
+	cout << "Number of resources to load across frames: " + to_string(_schedule.size()) << endl << endl;
+	LoadHandle _handle = createLoadHandle(_schedule);
 
-	_temp = Mix_LoadMUS(m_path[key].c_str());
-	if (_temp == 0)
-		throw(LoadException("Could not load music " + key + " from " + m_path[key] + "\n" + Mix_GetError() + "\n"));
+	for (auto& resource : _schedule)
+		m_pendingResources.push_back(make_pair(_handle, resource));
 
-	m_music[key] = _temp;
+	return _handle;
 }
 
-void ResourceManager::addSoundEffect(string key)
+void ResourceManager::setLazyLoading(bool lazy)
 {
-	Mix_Chunk* _temp = nullptr;
+	m_lazyLoading = lazy;
+}
 
-	if (!doesFileExists(m_path[key].c_str()))
-		throw(LoadException("Could not load sound effect " + key + " from " + m_path[key]));
+bool ResourceManager::isLazyLoading() const
+{
+	return m_lazyLoading;
+}
 
-	_temp = Mix_LoadWAV(m_path[key].c_str());
-	if (_temp == 0)
-		throw(LoadException("Could not load sound effect " + key + " from " + m_path[key] + "\n" + Mix_GetError() + "\n"));
+// Decodes the given resources in the background before they are first looked up.
+// Keys that are unknown, resident or already loading are skipped.
+LoadHandle ResourceManager::prefetch(const vector<string>& keys)
+{
+	vector<Residency*> _requested;
+	for (auto& key : keys)
+	{
+		ResourceHandle _handle;
+		if ((_handle = findHandle(m_textureHandles, key)) != INVALID_HANDLE)
+			_requested.push_back(findResidency(RESOURCE_TEXTURE, _handle));
+		else if ((_handle = findHandle(m_musicHandles, key)) != INVALID_HANDLE)
+			_requested.push_back(findResidency(RESOURCE_MUSIC, _handle));
+		else if ((_handle = findHandle(m_soundEffectHandles, key)) != INVALID_HANDLE)
+			_requested.push_back(findResidency(RESOURCE_SOUND_EFFECT, _handle));
+	}
+
+	sort(_requested.begin(), _requested.end());
+	_requested.erase(unique(_requested.begin(), _requested.end()), _requested.end());
+
+	// the handle has to know its total before the first decode can finish
+	unsigned int _total = 0;
+	for (auto& residency : _requested)
+	{
+		if (residency->needsDecode())
+			_total++;
+	}
+
+	LoadHandle _handle = make_shared<LoadProgress>(_total);
+	for (auto& residency : _requested)
+		requestDecode(residency, _handle);
 
-	m_soundEffects[key] = _temp;
+	return _handle;
 }
 
-void ResourceManager::checkJsonObject(const Value& object, string type)
+// Takes a reference on every member of the group and decodes the ones that are not resident.
+// A resource shared with another loaded group stays resident until both are unloaded.
+LoadHandle ResourceManager::loadGroup(const string& name)
 {
-	string _key = object["key"].GetString();
-	string _path = object["path"].GetString();
+	ResourceGroup* _group = m_groups.find(name);
+	if (!_group)
+	{
+		cout << "Unknown resource group " << name << endl;
+		return make_shared<LoadProgress>(0);
+	}
 
-	m_path[_key] = _path;
+	if (_group->m_loaded)
+		return make_shared<LoadProgress>(0);
+	_group->m_loaded = true;
 
-	if (type == "texture")
-		addResourceToQueue(new Texture(_key, _path));
-	else if (type == "music")
-		addResourceToQueue(new Music(_key, _path));
-	else if (type == "effect")
-		addResourceToQueue(new SoundEffect(_key, _path));
-	else
+	vector<Residency*> _requested;
+	unsigned int _critical = 0;
+	for (auto& member : _group->m_members)
 	{
-		addResourceToQueue(new Texture(_key, _path));
+		Residency* _residency = findResidency(member.first, member.second);
+		_residency->m_references++;
 
-		vector<SDL_Rect>  animationList;
-		const Value& _meta = object["metaData"];
-
-		for (Value::ConstMemberIterator _it = _meta.MemberBegin(); _it != _meta.MemberEnd(); ++_it)
+		if (_residency->needsDecode())
 		{
-			SDL_Rect _tempRect = SDL_Rect();
-			_tempRect.w = _it->value["width"].GetDouble();
-			_tempRect.h = _it->value["height"].GetDouble();
-			_tempRect.x = _it->value["x"].GetDouble();
-			_tempRect.y = _it->value["y"].GetDouble();
-
-			animationList.push_back(_tempRect);
+			_requested.push_back(_residency);
+			if (_residency->m_descriptor.m_priority == PRIORITY_CRITICAL)
+				_critical++;
 		}
-
-		m_animations[_key] = animationList;
 	}
+
+	cout << "Loading group " << name << ": " << _requested.size() << " resources" << endl << endl;
+
+	LoadHandle _handle = make_shared<LoadProgress>(_requested.size(), _critical);
+	for (auto& residency : _requested)
+		requestDecode(residency, _handle);
+
+	return _handle;
 }
 
-void ResourceManager::reloadTexture(string key)
+// Drops the group's references and frees every member no other group or acquire() still holds.
+// Atlased members give their space back and playing audio is retired until it stops, so only a
+// placeholder stays resident.
+void ResourceManager::unloadGroup(const string& name)
 {
-	SDL_Texture* _temp = IMG_LoadTexture(m_renderer, m_path[key].c_str());
-	if (_temp == 0)
-		throw(LoadException("Could not load texture " + key + " from " + m_path[key] + "\n" + IMG_GetError() + "\n"));
+	ResourceGroup* _group = m_groups.find(name);
+	if (!_group || !_group->m_loaded)
+		return;
+	_group->m_loaded = false;
+
+	for (auto& member : _group->m_members)
+	{
+		Residency* _residency = findResidency(member.first, member.second);
+		if (_residency->m_references > 0)
+			_residency->m_references--;
 
-	SDL_DestroyTexture(m_textures[key].first);
-	m_textures[key].first = _temp;
-	m_textures[key].second = getTimeInfo(m_path[key].c_str());
+		if (_residency->m_references == 0 && _residency->m_bytes > 0)
+		{
+			if (isPlaceholder(member.first, member.second))
+				cout << "Kept " << _residency->m_descriptor.m_key << " resident after unloading group " << name << ", it is a placeholder" << endl;
+			else
+				freeResource(member.first, member.second);
+		}
+	}
 }
 
-void ResourceManager::loadAnimations(ifstream* file, vector<SDL_Rect>* list)
+bool ResourceManager::isGroupLoaded(const string& name) const
 {
-	string _line;
-	*file >> _line;
-	int _width = stoi(_line);
-	*file >> _line;
-	int _height = stoi(_line);
-	*file >> _line;
-	int _x = stoi(_line);
-	*file >> _line;
-	int _y = stoi(_line);
+	const ResourceGroup* _group = m_groups.find(name);
+	return _group && _group->m_loaded;
+}
 
-	SDL_Rect _tempRect = SDL_Rect();
-	_tempRect.w = _width;
-	_tempRect.h = _height;
-	_tempRect.x = _x;
-	_tempRect.y = _y;
+void ResourceManager::enableTextureCache(string directory, uint64_t maxBytes)
+{
+	m_textureCache = make_shared<TextureCache>(directory, maxBytes);
+}
 
-	list->push_back(_tempRect);
+void ResourceManager::enableTextureAtlas(int pageSize, int maxSpriteSize)
+{
+	m_atlas = make_shared<TextureAtlas>(m_renderer, pageSize, maxSpriteSize);
 }
 
+void ResourceManager::setFrameBudget(float milliseconds)
+{
+	m_frameBudget = milliseconds;
+}
 
-tm ResourceManager::getTimeInfo(const char* path)
+float ResourceManager::getFrameBudget() const
 {
-	struct stat _result;
-	if (stat(path, &_result) == 0)
-	{
-		tm _timeInfo = tm();
-		localtime_s(&_timeInfo, &_result.st_mtime);
-		return _timeInfo;
-	}
+	return m_frameBudget;
 }
 
-vector<SDL_Rect> ResourceManager::getAnimationFrames(string key)
+bool ResourceManager::playMusic(ResourceHandle handle, int loops)
 {
-	auto _animations = m_animations.find(key);
+	Mix_Music* _music = getMusic(handle);
+	if (!_music || Mix_PlayMusic(_music, loops) == -1)
+		return false;
 
-	if (_animations != m_animations.end())
-		return _animations->second;
-	else
-		return m_animations["placeholder"];
+	m_playingMusic = handle;
+	m_playingMusicLoops = loops;
+	return true;
 }
 
-void ResourceManager::reloadFromXML()
+void ResourceManager::setMemoryBudget(ResourceType type, uint64_t bytes)
 {
-	string _line;
-	ifstream _myFile(m_source);
+	m_memoryBudgets[type] = bytes;
+	enforceBudget(type);
+}
 
-	xml_document<> _document;
-	std::stringstream _buffer;
-	_buffer << _myFile.rdbuf();
-	_myFile.close();
-	std::string content(_buffer.str());
-	_document.parse<0>(&content[0]);
+uint64_t ResourceManager::getMemoryBudget(ResourceType type) const
+{
+	return m_memoryBudgets[type];
+}
 
-	xml_node<>* _root = _document.first_node();
-	xml_node<>* _assets = _root->first_node("textures");
-	_assets = _assets->next_sibling(); 
-	_assets = _assets->next_sibling();
-	_assets = _assets->next_sibling(); 
+void ResourceManager::acquire(ResourceType type, ResourceHandle handle)
+{
+	Residency* _residency = findResidency(type, handle);
+	if (_residency)
+		_residency->m_references++;
+}
 
-	xml_node<>* _animation = _assets->first_node("animation");
-	while (_animation != 0)
+void ResourceManager::release(ResourceType type, ResourceHandle handle)
+{
+	Residency* _residency = findResidency(type, handle);
+	if (_residency && _residency->m_references > 0)
 	{
-		string _key = _animation->first_node("key")->value();
+		_residency->m_references--;
+		if (_residency->m_references == 0)
+			enforceBudget(type);
+	}
+}
 
-		vector<SDL_Rect> _animationList;
-		xml_node<>* _frame = _animation->first_node("metaData")->first_node("frame");
+ResourceStats ResourceManager::getStats(size_t largestCount)
+{
+	ResourceStats _stats = ResourceStats();
+	_stats.m_peakBytes = m_peakBytes;
 
-		while (_frame != 0)
+	size_t _counts[] = { m_textures.size(), m_music.size(), m_soundEffects.size() };
+	for (int _type = RESOURCE_TEXTURE; _type <= RESOURCE_SOUND_EFFECT; _type++)
+	{
+		for (ResourceHandle i = 0; i < _counts[_type]; i++)
 		{
-			SDL_Rect _tempRect = SDL_Rect();
-			_tempRect.w = stoi(_frame->first_node("width")->value());
-			_tempRect.h = stoi(_frame->first_node("height")->value());
-			_tempRect.x = stoi(_frame->first_node("x")->value());
-			_tempRect.y = stoi(_frame->first_node("y")->value());
-
-			_animationList.push_back(_tempRect);
-
-			_frame = _frame->next_sibling();
+			const Residency* _residency = findResidency((ResourceType)_type, i);
+			if (_residency->m_bytes == 0)
+				continue;
+
+			if (_residency->m_charged)
+				_stats.m_bytes[_type] += _residency->m_bytes;
+			_stats.m_resident[_type]++;
+
+			ResourceUsage _usage;
+			_usage.m_key = _residency->m_descriptor.m_key;
+			_usage.m_type = (ResourceType)_type;
+			_usage.m_bytes = _residency->m_bytes;
+			_stats.m_largest.push_back(_usage);
 		}
 
-		m_animations[_key] = _animationList;
-		_animation = _animation->next_sibling();
+		_stats.m_totalBytes += _stats.m_bytes[_type];
 	}
+
+	_stats.m_atlasBytes = m_atlas ? m_atlas->getBytes() : 0;
+	_stats.m_totalBytes += _stats.m_atlasBytes;
+
+	size_t _keep = min(largestCount, _stats.m_largest.size());
+	partial_sort(_stats.m_largest.begin(), _stats.m_largest.begin() + _keep, _stats.m_largest.end(),
+		[](const ResourceUsage& a, const ResourceUsage& b) { return a.m_bytes > b.m_bytes; });
+	_stats.m_largest.resize(_keep);
+
+	return _stats;
 }
 
-void ResourceManager::reloadFromJSON()
+// Resources still to come in: waiting for their frame, or decoding on the pool and not yet picked up
+unsigned int ResourceManager::getQueueDepth()
 {
-	FILE* _file = new FILE();
-	fopen_s(&_file, m_source.c_str(), "rb");
-	char readBuffer[65536];
-	FileReadStream _is(_file, readBuffer, sizeof(readBuffer));
-	Document _document;
-	_document.ParseStream(_is);
-	fclose(_file);
+	return m_pendingResources.size() + m_decodesInFlight;
+}
 
-	const Value& _resources = _document["resources"];
+void ResourceManager::addResourceToQueue(ResourceType type, const string& key, const string& path, ResourcePriority priority,
+	const vector<string>& groups)
+{
+	addResourceToQueue(type, key.c_str(), path.c_str(), priority, groups);
+}
 
-	const Value& _animations = _resources["animations"];
-	for (Value::ConstMemberIterator _it = _animations.MemberBegin(); _it != _animations.MemberEnd(); ++_it)
+void ResourceManager::addResourceToQueue(ResourceType type, const char* key, const char* path, ResourcePriority priority,
+	const vector<string>& groups)
+{
+	ResourceHandle _handle = INVALID_HANDLE;
+	switch (type)
 	{
-		string name = _it->name.GetString();
-		const Value& _a = _animations[name.c_str()];
-
-		string _key = _a["key"].GetString();
+	case RESOURCE_TEXTURE:
+		_handle = reserveHandle(&m_textureHandles, &m_textures, key);
+		break;
+	case RESOURCE_MUSIC:
+		_handle = reserveHandle(&m_musicHandles, &m_music, key);
+		break;
+	case RESOURCE_SOUND_EFFECT:
+		_handle = reserveHandle(&m_soundEffectHandles, &m_soundEffects, key);
+		break;
+	}
 
-		vector<SDL_Rect>  animationList;
-		const Value& _meta = _a["metaData"];
+	Resource _resource;
+	_resource.m_key = m_strings.store(key, strlen(key));
+	_resource.m_path = m_strings.store(path, strlen(path));
+	_resource.m_type = type;
+	_resource.m_priority = priority;
+	m_resourceQueue.push_back(_resource);
+
+	// the slot is already on its way in, so touching it must not queue a second decode
+	Residency* _residency = findResidency(type, _handle);
+	_residency->m_descriptor = _resource;
+	_residency->m_reloading = _residency->m_bytes == 0;
+	_residency->m_failed = false;
+	_residency->m_grouped = !groups.empty();
+
+	for (auto& group : groups)
+	{
+		vector<pair<ResourceType, ResourceHandle>>& _members = m_groups[group].m_members;
+		if (find(_members.begin(), _members.end(), make_pair(type, _handle)) == _members.end())
+			_members.push_back(make_pair(type, _handle));
+	}
+}
 
-		for (Value::ConstMemberIterator _it = _meta.MemberBegin(); _it != _meta.MemberEnd(); ++_it)
+vector<Resource> ResourceManager::getScheduledQueue()
+{
+	// manifest order is kept between resources of the same priority
+	vector<Resource> _schedule;
+	for (auto& resource : m_resourceQueue)
+	{
+		ResourceType _type = resource.m_type;
+		ResourceHandle _handle = INVALID_HANDLE;
+		switch (_type)
 		{
-			SDL_Rect _tempRect = SDL_Rect();
-			_tempRect.w = _it->value["width"].GetDouble();
-			_tempRect.h = _it->value["height"].GetDouble();
-			_tempRect.x = _it->value["x"].GetDouble();
-			_tempRect.y = _it->value["y"].GetDouble();
+		case RESOURCE_TEXTURE:
+			_handle = findHandle(m_textureHandles, resource.m_key);
+			break;
+		case RESOURCE_MUSIC:
+			_handle = findHandle(m_musicHandles, resource.m_key);
+			break;
+		case RESOURCE_SOUND_EFFECT:
+			_handle = findHandle(m_soundEffectHandles, resource.m_key);
+			break;
+		}
 
-			animationList.push_back(_tempRect);
+		// a lazy resource is only registered, its first lookup or a prefetch decodes it,
+		// and a grouped one waits for loadGroup
+		Residency* _residency = findResidency(_type, _handle);
+		bool _deferred = m_lazyLoading && resource.m_priority != PRIORITY_CRITICAL && string(resource.m_key) != "placeholder";
+		if (_deferred || _residency->m_grouped)
+		{
+			_residency->m_reloading = false;
+			continue;
 		}
 
-		m_animations[_key] = animationList;
+		_schedule.push_back(resource);
 	}
+
+	stable_sort(_schedule.begin(), _schedule.end(), [](const Resource& a, const Resource& b)
+	{
+		return a.m_priority < b.m_priority;
+	});
+
+	return _schedule;
 }
 
-void ResourceManager::reloadFromText()
+void ResourceManager::enqueueDecode(LoadHandle handle, const Resource& resource, bool hotReload)
 {
-	string _key, _path, _type;
-	ifstream _myFile;
-	_myFile.open(m_source);
+	shared_ptr<DecodedResource> _decoded = make_shared<DecodedResource>();
+	_decoded->resource = resource;
+	_decoded->hotReload = hotReload;
 
-	while (_myFile >> _type >> _key >> _path)
+	m_decodesInFlight++;
+	m_loaderPool.enqueue([this, handle, _decoded]()
 	{
-		if (_type == "animation")
-		{
-			string _line;
-			_myFile >> _line;
+		decodeResource(_decoded.get());
+		handle->markDecoded();
 
-			vector<SDL_Rect> _animationList;
+		lock_guard<mutex> _lock(m_decodedMutex);
+		m_decodedResources.push_back(make_pair(handle, _decoded));
+	});
+}
 
-			int _frames = stoi(_line);
-			for (int i = 1; i <= _frames; i++)
-				loadAnimations(&_myFile, &_animationList);
+LoadHandle ResourceManager::createLoadHandle(const vector<Resource>& schedule)
+{
+	unsigned int _critical = 0;
+	for (auto& resource : schedule)
+	{
+		if (resource.m_priority == PRIORITY_CRITICAL)
+			_critical++;
+	}
 
-			m_animations[_key] = _animationList;
+	return make_shared<LoadProgress>(schedule.size(), _critical);
+}
+
+void ResourceManager::decodeResource(DecodedResource* decoded)
+{
+	string _key = decoded->resource.m_key;
+	string _path = decoded->resource.m_path;
+	shared_ptr<MappedFile> _file;
+	const unsigned char* _data = nullptr;
+	size_t _size = 0;
+
+	switch (decoded->resource.m_type)
+	{
+	case RESOURCE_TEXTURE:
+	{
+		if (!openResourceData(_key, PACK_TEXTURE, _path, !decoded->hotReload, &_file, &_data, &_size))
+		{
+			decoded->error = "Could not load texture " + _key + " from " + _path;
+			return;
+		}
+
+		// a warm cache skips the image decode entirely
+		uint64_t _cacheKey = 0;
+		if (m_textureCache)
+		{
+			_cacheKey = TextureCache::makeKey(_path, _data, _size);
+			if (m_textureCache->load(_cacheKey, &decoded->cachedTexture))
+				return;
+		}
+
+		if ((decoded->surface = IMG_Load_RW(SDL_RWFromConstMem(_data, (int)_size), 1)) == 0)
+			decoded->error = "Could not load texture " + _key + " from " + _path + "\n" + IMG_GetError() + "\n";
+		else if (m_textureCache)
+			decoded->surface = m_textureCache->store(_cacheKey, _path, decoded->surface);
+		break;
+	}
+	case RESOURCE_MUSIC:
+		if (!openResourceData(_key, PACK_MUSIC, _path, !decoded->hotReload, &_file, &_data, &_size))
+			decoded->error = "Could not load music " + _key + " from " + _path;
+		else if ((decoded->music = Mix_LoadMUS_RW(SDL_RWFromConstMem(_data, (int)_size), 1)) == 0)
+			decoded->error = "Could not load music " + _key + " from " + _path + "\n" + Mix_GetError() + "\n";
+		else
+			decoded->musicFile = _file;
+		break;
+	case RESOURCE_SOUND_EFFECT:
+		if (!openResourceData(_key, PACK_SOUND_EFFECT, _path, !decoded->hotReload, &_file, &_data, &_size))
+			decoded->error = "Could not load sound effect " + _key + " from " + _path;
+		else if ((decoded->soundEffect = Mix_LoadWAV_RW(SDL_RWFromConstMem(_data, (int)_size), 1)) == 0)
+			decoded->error = "Could not load sound effect " + _key + " from " + _path + "\n" + Mix_GetError() + "\n";
+		break;
+	}
+
+	decoded->dataSize = _size;
+}
+
+bool ResourceManager::openResourceData(string key, PackEntryType type, string path, bool packed, shared_ptr<MappedFile>* file,
+	const unsigned char** data, size_t* size)
+{
+	// packed data wins over loose files
+	if (m_pack && packed)
+	{
+		const PackEntry* _entry = m_pack->find(key, type);
+		if (_entry)
+		{
+			if (!m_pack->verify(_entry))
+			{
+				cout << "Checksum mismatch for " + key + " in resource pack" << endl;
+				return false;
+			}
+
+			*file = m_pack->getFile();
+			*data = m_pack->getData(_entry);
+			*size = (size_t)_entry->m_size;
+			return true;
+		}
+	}
+
+	*file = make_shared<MappedFile>();
+	if (!(*file)->open(path))
+		return false;
+
+	*data = (*file)->getData();
+	*size = (*file)->getSize();
+	return true;
+}
+
+void ResourceManager::loadResource(DecodedResource* decoded)
+{
+	string _key = decoded->resource.m_key;
+
+	// the manifest was edited while this decoded: the key is gone, or it now loads from another file
+	Residency* _residency = findResidency(decoded->resource.m_type, findResourceHandle(decoded->resource.m_type, _key));
+	if (!_residency || strcmp(_residency->m_descriptor.m_path, decoded->resource.m_path) != 0)
+	{
+		freeDecodedResource(decoded);
+		if (_residency)
+		{
+			_residency->m_reloading = false;
+			requestDecode(_residency);
+		}
+		return;
+	}
+
+	m_resourcesLoaded++;
+	watchResource(decoded->resource.m_type, findResourceHandle(decoded->resource.m_type, _key));
+
+	if (decoded->surface)
+		addTexture(_key, decoded->surface);
+	else if (decoded->cachedTexture.m_pixels)
+		addTexture(_key, decoded->cachedTexture);
+	else if (decoded->music)
+		addMusic(_key, decoded->music, decoded->musicFile, decoded->dataSize);
+	else
+		addSoundEffect(_key, decoded->soundEffect);
+
+	float _percentage = m_resourcesLoaded / m_resourceQueue.size();
+	cout << "Current Resource: " + _key << endl;
+	cout << "Loading... " + to_string(_percentage) + "%" << endl << endl;
+}
+
+void ResourceManager::processDecodedResources(Uint64 frameStart)
+{
+	while (!isFrameBudgetSpent(frameStart))
+	{
+		pair<LoadHandle, shared_ptr<DecodedResource>> _ready;
+		{
+			lock_guard<mutex> _lock(m_decodedMutex);
+			if (m_decodedResources.empty())
+				return;
+
+			_ready = m_decodedResources.front();
+			m_decodedResources.pop_front();
+		}
+		m_decodesInFlight--;
+
+		DecodedResource* _decoded = _ready.second.get();
+		string _error = _decoded->error;
+
+		if (_error.empty())
+		{
+			try
+			{
+				loadResource(_decoded);
+			}
+			catch (LoadException&)
+			{
+				_error = string("Could not load ") + _decoded->resource.m_key;
+			}
+		}
+
+		if (!_error.empty())
+			abandonDecode(_decoded->resource);
+
+		_ready.first->markLoaded(_error, _decoded->resource.m_priority == PRIORITY_CRITICAL);
+	}
+}
+
+void ResourceManager::processPendingResources(Uint64 frameStart)
+{
+	while (!m_pendingResources.empty() && !isFrameBudgetSpent(frameStart))
+	{
+		pair<LoadHandle, Resource> _pending = m_pendingResources.front();
+		m_pendingResources.pop_front();
+
+		DecodedResource _decoded;
+		_decoded.resource = _pending.second;
+		decodeResource(&_decoded);
+		_pending.first->markDecoded();
+
+		string _error = _decoded.error;
+		if (_error.empty())
+		{
+			try
+			{
+				loadResource(&_decoded);
+			}
+			catch (LoadException&)
+			{
+				_error = string("Could not load ") + _decoded.resource.m_key;
+			}
+		}
+
+		if (!_error.empty())
+			abandonDecode(_decoded.resource);
+
+		_pending.first->markLoaded(_error, _pending.second.m_priority == PRIORITY_CRITICAL);
+	}
+}
+
+// A failed decode leaves the slot as it was. It is not decoded again until its file or manifest entry changes.
+void ResourceManager::abandonDecode(const Resource& resource)
+{
+	// a decode of a path the manifest has since moved away from says nothing about the new one
+	Residency* _residency = findResidency(resource.m_type, findResourceHandle(resource.m_type, resource.m_key));
+	if (_residency && strcmp(_residency->m_descriptor.m_path, resource.m_path) == 0)
+	{
+		_residency->m_reloading = false;
+		_residency->m_failed = true;
+		watchResource(resource.m_type, findResourceHandle(resource.m_type, resource.m_key));
+	}
+}
+
+// Resources are watched once their first decode is done, with its file already read, so queueing
+// a manifest is only the descriptors. A failed one is watched too, so saving a fix retries it.
+void ResourceManager::watchResource(ResourceType type, ResourceHandle handle)
+{
+	const char* _path = findResidency(type, handle)->m_descriptor.m_path;
+	vector<pair<ResourceType, ResourceHandle>>& _watched = m_watchedResources[_path];
+	if (find(_watched.begin(), _watched.end(), make_pair(type, handle)) != _watched.end())
+		return;
+
+	_watched.push_back(make_pair(type, handle));
+	m_watcher.watch(_path);
+}
+
+bool ResourceManager::isFrameBudgetSpent(Uint64 frameStart)
+{
+	// a budget of zero means there is no limit
+	if (m_frameBudget <= 0)
+		return false;
+
+	double _elapsed = (double)(SDL_GetPerformanceCounter() - frameStart) * 1000.0 / SDL_GetPerformanceFrequency();
+	return _elapsed >= m_frameBudget;
+}
+
+void ResourceManager::freeDecodedResource(DecodedResource* decoded)
+{
+	if (decoded->surface)
+		SDL_FreeSurface(decoded->surface);
+	decoded->cachedTexture = CachedTexture();
+	if (decoded->music)
+		Mix_FreeMusic(decoded->music);
+	decoded->musicFile = nullptr;
+	if (decoded->soundEffect)
+		Mix_FreeChunk(decoded->soundEffect);
+
+	decoded->surface = nullptr;
+	decoded->music = nullptr;
+	decoded->soundEffect = nullptr;
+}
+
+void ResourceManager::addTexture(string key, SDL_Surface* surface)
+{
+	if (addToAtlas(key, surface))
+	{
+		SDL_FreeSurface(surface);
+		return;
+	}
+
+	SDL_Texture* _temp = SDL_CreateTextureFromSurface(m_renderer, surface);
+	SDL_FreeSurface(surface);
+
+	TextureEntry& _entry = m_textures[reserveHandle(&m_textureHandles, &m_textures, key)];
+	if (_temp == 0)
+		throw(LoadException("Could not load texture " + key + " from " + _entry.m_residency.m_descriptor.m_path + "\n" + SDL_GetError() + "\n"));
+
+	Uint32 _format = 0;
+	_entry.m_texture = _temp;
+	_entry.m_source = SDL_Rect();
+	SDL_QueryTexture(_temp, &_format, NULL, &_entry.m_source.w, &_entry.m_source.h);
+	_entry.m_atlased = false;
+	setResidentBytes(RESOURCE_TEXTURE, &_entry.m_residency, (uint64_t)_entry.m_source.w * _entry.m_source.h * SDL_BYTESPERPIXEL(_format));
+	placeAnimationFrames(key);
+	enforceBudget(RESOURCE_TEXTURE);
+}
+
+void ResourceManager::addTexture(string key, const CachedTexture& cached)
+{
+	// the atlas takes surfaces, so wrap the cached pixels without copying them
+	if (m_atlas && m_atlas->canPack(cached.m_width, cached.m_height))
+	{
+		int _bpp;
+		Uint32 _r, _g, _b, _a;
+		SDL_PixelFormatEnumToMasks(cached.m_format, &_bpp, &_r, &_g, &_b, &_a);
+
+		SDL_Surface* _surface = SDL_CreateRGBSurfaceFrom((void*)cached.m_pixels, cached.m_width, cached.m_height,
+			_bpp, cached.m_pitch, _r, _g, _b, _a);
+		bool _packed = _surface && addToAtlas(key, _surface);
+		SDL_FreeSurface(_surface);
+
+		if (_packed)
+			return;
+	}
+
+	SDL_Texture* _temp = SDL_CreateTexture(m_renderer, cached.m_format, SDL_TEXTUREACCESS_STATIC, cached.m_width, cached.m_height);
+	if (_temp == 0 || SDL_UpdateTexture(_temp, NULL, cached.m_pixels, cached.m_pitch) != 0)
+	{
+		string _error = SDL_GetError();
+		if (_temp)
+			SDL_DestroyTexture(_temp);
+		throw(LoadException("Could not load texture " + key + " from the texture cache\n" + _error + "\n"));
+	}
+
+	if (SDL_ISPIXELFORMAT_ALPHA(cached.m_format))
+		SDL_SetTextureBlendMode(_temp, SDL_BLENDMODE_BLEND);
+
+	TextureEntry& _entry = m_textures[reserveHandle(&m_textureHandles, &m_textures, key)];
+	_entry.m_texture = _temp;
+	_entry.m_source = SDL_Rect();
+	_entry.m_source.w = cached.m_width;
+	_entry.m_source.h = cached.m_height;
+	_entry.m_atlased = false;
+	setResidentBytes(RESOURCE_TEXTURE, &_entry.m_residency, (uint64_t)cached.m_pitch * cached.m_height);
+	placeAnimationFrames(key);
+	enforceBudget(RESOURCE_TEXTURE);
+}
+
+bool ResourceManager::addToAtlas(string key, SDL_Surface* surface)
+{
+	SDL_Texture* _page = nullptr;
+	SDL_Rect _source = SDL_Rect();
+	uint64_t _pageBytes = m_atlas ? m_atlas->getBytes() : 0;
+
+	if (!m_atlas || !m_atlas->pack(surface, &_page, &_source))
+		return false;
+
+	// the sprite only takes space on a page, a page the atlas had to add is what costs memory
+	m_residentBytes[RESOURCE_TEXTURE] += m_atlas->getBytes() - _pageBytes;
+
+	TextureEntry& _entry = m_textures[reserveHandle(&m_textureHandles, &m_textures, key)];
+	_entry.m_texture = _page;
+	_entry.m_source = _source;
+	_entry.m_atlased = true;
+	setResidentBytes(RESOURCE_TEXTURE, &_entry.m_residency, (uint64_t)_source.w * _source.h * 4, false);
+	placeAnimationFrames(key);
+	enforceBudget(RESOURCE_TEXTURE);
+	return true;
+}
+
+const TextureEntry* ResourceManager::findTextureEntry(ResourceHandle handle)
+{
+	if (handle < m_textures.size() && m_textures[handle].m_texture)
+		return &m_textures[handle];
+
+	if (m_textureHandles.m_placeholder < m_textures.size() && m_textures[m_textureHandles.m_placeholder].m_texture)
+		return &m_textures[m_textureHandles.m_placeholder];
+
+	return nullptr;
+}
+
+ResourceHandle ResourceManager::findHandle(const HandleTable& handles, const string& key) const
+{
+	const ResourceHandle* _handle = handles.m_names.find(key);
+	return _handle ? *_handle : INVALID_HANDLE;
+}
+
+ResourceHandle ResourceManager::findHandle(const HandleTable& handles, ResourceKey key) const
+{
+	const ResourceHandle* _handle = handles.m_keys.find(key.m_hash);
+	return _handle ? *_handle : INVALID_HANDLE;
+}
+
+// Looks a key up on behalf of the game, counting it in the miss report when it is not found
+ResourceHandle ResourceManager::lookupHandle(HandleTable* handles, const string& key)
+{
+	ResourceHandle _handle = findHandle(*handles, key);
+	if (_handle == INVALID_HANDLE)
+		recordMiss(handles, ResourceKey(key), &key);
+	return _handle;
+}
+
+ResourceHandle ResourceManager::lookupHandle(HandleTable* handles, ResourceKey key)
+{
+	ResourceHandle _handle = findHandle(*handles, key);
+	if (_handle == INVALID_HANDLE)
+		recordMiss(handles, key, nullptr);
+	return _handle;
+}
+
+void ResourceManager::recordMiss(HandleTable* handles, ResourceKey key, const string* name)
+{
+	KeyMiss& _miss = handles->m_misses[key.m_hash];
+	if (_miss.m_count++ > 0)
+		return;
+
+	// only the first miss of a key is logged, the rest are just counted
+	const string* _known = m_keyNames.find(key.m_hash);
+	if (name)
+		_miss.m_key = *name;
+	else if (_known)
+		_miss.m_key = *_known;
+	else
+	{
+		stringstream _hash;
+		_hash << hex << key.m_hash;
+		_miss.m_key = _hash.str();
+	}
+
+	_miss.m_kind = handles->m_kind;
+	cout << "Missing " << _miss.m_kind << " " << _miss.m_key << ", using the placeholder" << endl;
+}
+
+vector<KeyMiss> ResourceManager::getMissReport() const
+{
+	vector<KeyMiss> _report;
+	const HandleTable* _tables[] = { &m_textureHandles, &m_musicHandles, &m_soundEffectHandles, &m_animationHandles };
+	for (auto& table : _tables)
+	{
+		for (FlatMap<uint64_t, KeyMiss>::const_iterator _it = table->m_misses.begin(); _it != table->m_misses.end(); ++_it)
+			_report.push_back(_it->second);
+	}
+
+	stable_sort(_report.begin(), _report.end(), [](const KeyMiss& a, const KeyMiss& b) { return a.m_count > b.m_count; });
+	return _report;
+}
+
+void ResourceManager::clearMissReport()
+{
+	m_textureHandles.m_misses.clear();
+	m_musicHandles.m_misses.clear();
+	m_soundEffectHandles.m_misses.clear();
+	m_animationHandles.m_misses.clear();
+}
+
+ResourceKey ResourceManager::registerKey(const char* key, size_t length)
+{
+	ResourceKey _key(key, length);
+
+	// two keys with one hash would make _rk lookups ambiguous, so refuse the manifest
+	string* _name = m_keyNames.find(_key.m_hash);
+	if (!_name)
+		m_keyNames[_key.m_hash] = string(key, length);
+	else if (_name->compare(0, string::npos, key, length) != 0)
+		throw(LoadException("Resource keys " + *_name + " and " + string(key, length) + " have the same hash\n"));
+
+	return _key;
+}
+
+void ResourceManager::setAnimationFrames(const string& key, const vector<SDL_Rect>& frames)
+{
+	setAnimationFrames(key.c_str(), frames.data(), frames.size());
+}
+
+void ResourceManager::setAnimationFrames(const char* key, const SDL_Rect* frames, size_t count)
+{
+	ResourceHandle _texture = reserveHandle(&m_textureHandles, &m_textures, key);
+	ResourceHandle _animation = reserveHandle(&m_animationHandles, &m_animations, key);
+	AnimationEntry& _entry = m_animations[_animation];
+	_entry.m_texture = _texture;
+
+	// reuse the old range when the frames still fit, otherwise append a new one
+	if (count > _entry.m_frameCount)
+	{
+		_entry.m_firstFrame = m_authoredFrames.size();
+		m_authoredFrames.resize(m_authoredFrames.size() + count);
+		m_frameArena.resize(m_authoredFrames.size());
+	}
+
+	_entry.m_frameCount = count;
+	copy(frames, frames + count, m_authoredFrames.begin() + _entry.m_firstFrame);
+	placeAnimationFrames(_animation);
+}
+
+// Frames are authored against the sprite sheet, so move them to where it sits on its atlas page.
+// SDL clips a frame that overhangs a texture of its own, on a page it is clipped here instead so
+// it never samples the padding or a neighbouring sprite.
+void ResourceManager::placeAnimationFrames(const string& key)
+{
+	ResourceHandle _animation = findHandle(m_animationHandles, key);
+	if (_animation != INVALID_HANDLE)
+		placeAnimationFrames(_animation);
+}
+
+void ResourceManager::placeAnimationFrames(ResourceHandle animation)
+{
+	const AnimationEntry& _entry = m_animations[animation];
+	const TextureEntry& _texture = m_textures[_entry.m_texture];
+	bool _atlased = _texture.m_texture && _texture.m_atlased;
+
+	for (unsigned int i = _entry.m_firstFrame; i < _entry.m_firstFrame + _entry.m_frameCount; i++)
+	{
+		m_frameArena[i] = m_authoredFrames[i];
+		if (_atlased)
+		{
+			SDL_Rect _frame = m_authoredFrames[i];
+			_frame.x += _texture.m_source.x;
+			_frame.y += _texture.m_source.y;
+
+			if (!SDL_IntersectRect(&_frame, &_texture.m_source, &m_frameArena[i]))
+				m_frameArena[i] = { _frame.x, _frame.y, 0, 0 };
+		}
+	}
+}
+
+vector<SDL_Rect> ResourceManager::getAuthoredFrames(ResourceHandle handle)
+{
+	const AnimationEntry& _entry = m_animations[handle];
+	return vector<SDL_Rect>(m_authoredFrames.begin() + _entry.m_firstFrame,
+		m_authoredFrames.begin() + _entry.m_firstFrame + _entry.m_frameCount);
+}
+
+void ResourceManager::addMusic(string key, Mix_Music* music, shared_ptr<MappedFile> file, size_t size)
+{
+	ResourceHandle _handle = reserveHandle(&m_musicHandles, &m_music, key);
+	MusicEntry& _entry = m_music[_handle];
+
+	// a hot reload of the track playMusic started restarts it, SDL_mixer cannot swap a playing stream
+	bool _restart = false;
+	if (_entry.m_music)
+	{
+		bool _playing = Mix_PlayingMusic() != 0;
+		_restart = _playing && m_playingMusic == _handle;
+
+		if (_restart)
+			Mix_HaltMusic();
+
+		// with no record of what is playing, the old track is kept until the music stops
+		if (_playing && !_restart && m_playingMusic == INVALID_HANDLE)
+			m_retiredMusic.push_back(make_pair(_entry.m_music, _entry.m_file));
+		else
+			Mix_FreeMusic(_entry.m_music);
+	}
+
+	_entry.m_music = music;
+	_entry.m_file = file;
+	setResidentBytes(RESOURCE_MUSIC, &_entry.m_residency, size);
+
+	if (_restart && Mix_PlayMusic(music, m_playingMusicLoops) == -1)
+		cout << "Could not restart " << key << " after reloading it" << endl;
+
+	enforceBudget(RESOURCE_MUSIC);
+}
+
+void ResourceManager::addSoundEffect(string key, Mix_Chunk* soundEffect)
+{
+	SoundEffectEntry& _entry = m_soundEffects[reserveHandle(&m_soundEffectHandles, &m_soundEffects, key)];
+
+	// a chunk replaced while it plays is freed once its channels finish, new plays get the new chunk
+	if (_entry.m_chunk && isChunkPlaying(_entry.m_chunk))
+		m_retiredChunks.push_back(_entry.m_chunk);
+	else if (_entry.m_chunk)
+		Mix_FreeChunk(_entry.m_chunk);
+
+	_entry.m_chunk = soundEffect;
+	setResidentBytes(RESOURCE_SOUND_EFFECT, &_entry.m_residency, soundEffect->alen);
+	enforceBudget(RESOURCE_SOUND_EFFECT);
+}
+
+// Decodes a changed music or sound effect file on a worker, the swap happens when update() picks up the result
+void ResourceManager::reloadAudio(ResourceType type, ResourceHandle handle)
+{
+	Residency* _residency = findResidency(type, handle);
+	if (_residency->m_bytes == 0)
+		return;
+
+	cout << "Reloading " << _residency->m_descriptor.m_key << endl;
+	enqueueDecode(make_shared<LoadProgress>(1), _residency->m_descriptor, true);
+}
+
+void ResourceManager::freeRetiredAudio(bool all)
+{
+	for (size_t i = 0; i < m_retiredChunks.size();)
+	{
+		if (!all && isChunkPlaying(m_retiredChunks[i]))
+		{
+			i++;
+			continue;
+		}
+
+		Mix_FreeChunk(m_retiredChunks[i]);
+		m_retiredChunks.erase(m_retiredChunks.begin() + i);
+	}
+
+	if (all || !Mix_PlayingMusic())
+	{
+		for (auto& music : m_retiredMusic)
+			Mix_FreeMusic(music.first);
+		m_retiredMusic.clear();
+	}
+}
+
+Residency* ResourceManager::findResidency(ResourceType type, ResourceHandle handle)
+{
+	switch (type)
+	{
+	case RESOURCE_TEXTURE:
+		return handle < m_textures.size() ? &m_textures[handle].m_residency : nullptr;
+	case RESOURCE_MUSIC:
+		return handle < m_music.size() ? &m_music[handle].m_residency : nullptr;
+	case RESOURCE_SOUND_EFFECT:
+		return handle < m_soundEffects.size() ? &m_soundEffects[handle].m_residency : nullptr;
+	}
+
+	return nullptr;
+}
+
+// Marks a resource as used, and starts decoding it if it was evicted or deferred by lazy loading
+void ResourceManager::touch(ResourceType type, ResourceHandle handle)
+{
+	Residency* _residency = findResidency(type, handle);
+	if (!_residency)
+		return;
+
+	_residency->m_lastUsed = ++m_useClock;
+	requestDecode(_residency);
+}
+
+// Starts decoding a known resource that is not resident and not already on its way in.
+// Without a handle one is only made when a decode is queued, since every lookup comes through here.
+bool ResourceManager::requestDecode(Residency* residency, LoadHandle handle)
+{
+	if (!residency->needsDecode())
+		return false;
+
+	if (!handle)
+		handle = make_shared<LoadProgress>(1);
+
+	residency->m_reloading = true;
+	enqueueDecode(handle, residency->m_descriptor);
+	return true;
+}
+
+void ResourceManager::setResidentBytes(ResourceType type, Residency* residency, uint64_t bytes, bool charged)
+{
+	m_residentBytes[type] += charged ? bytes : 0;
+	m_residentBytes[type] -= residency->m_charged ? residency->m_bytes : 0;
+	residency->m_bytes = bytes;
+	residency->m_charged = charged;
+
+	uint64_t _total = 0;
+	for (int i = RESOURCE_TEXTURE; i <= RESOURCE_SOUND_EFFECT; i++)
+		_total += m_residentBytes[i];
+	m_peakBytes = max(m_peakBytes, _total);
+
+	// a resource that has just arrived counts as used, so it is not the first thing evicted
+	if (bytes > 0)
+	{
+		residency->m_lastUsed = ++m_useClock;
+		residency->m_reloading = false;
+	}
+}
+
+// Evicts unreferenced resources of one type, least recently used first, until the type fits its budget
+// or nothing left can be freed. Placeholders, atlased sprites and playing audio are passed over.
+void ResourceManager::enforceBudget(ResourceType type)
+{
+	while (m_memoryBudgets[type] > 0 && m_residentBytes[type] > m_memoryBudgets[type])
+	{
+		size_t _count = type == RESOURCE_TEXTURE ? m_textures.size() : (type == RESOURCE_MUSIC ? m_music.size() : m_soundEffects.size());
+
+		ResourceHandle _oldest = INVALID_HANDLE;
+		uint64_t _oldestUse = 0;
+		for (ResourceHandle i = 0; i < _count; i++)
+		{
+			const Residency* _residency = findResidency(type, i);
+			if (_residency->m_bytes == 0 || _residency->m_references > 0 || !_residency->m_descriptor.m_key || !isEvictable(type, i))
+				continue;
+
+			if (_oldest == INVALID_HANDLE || _residency->m_lastUsed < _oldestUse)
+			{
+				_oldest = i;
+				_oldestUse = _residency->m_lastUsed;
+			}
+		}
+
+		if (_oldest == INVALID_HANDLE || !evict(type, _oldest))
+			return;
+	}
+}
+
+bool ResourceManager::isPlaceholder(ResourceType type, ResourceHandle handle) const
+{
+	switch (type)
+	{
+	case RESOURCE_TEXTURE:
+		return handle == m_textureHandles.m_placeholder;
+	case RESOURCE_MUSIC:
+		return handle == m_musicHandles.m_placeholder;
+	case RESOURCE_SOUND_EFFECT:
+		return handle == m_soundEffectHandles.m_placeholder;
+	}
+
+	return false;
+}
+
+// Whether a resident resource can be freed without anyone hearing or seeing the difference
+bool ResourceManager::isEvictable(ResourceType type, ResourceHandle handle)
+{
+	if (isPlaceholder(type, handle))
+		return false;
+
+	switch (type)
+	{
+	case RESOURCE_MUSIC:
+		// with no record of what is playing, every track is assumed to be
+		return !(Mix_PlayingMusic() && (m_playingMusic == handle || m_playingMusic == INVALID_HANDLE));
+	case RESOURCE_SOUND_EFFECT:
+		return !isChunkPlaying(m_soundEffects[handle].m_chunk);
+	case RESOURCE_TEXTURE:
+		// pages are never freed, so evicting an atlased sprite would not give back any memory
+		return !m_textures[handle].m_atlased;
+	default:
+		return true;
+	}
+}
+
+bool ResourceManager::evict(ResourceType type, ResourceHandle handle)
+{
+	if (!isEvictable(type, handle))
+		return false;
+
+	freeResource(type, handle);
+	cout << "Evicted " << findResidency(type, handle)->m_descriptor.m_key << endl;
+	return true;
+}
+
+// Frees a resident resource now. An atlased sprite gives its space back to the page,
+// and audio that is still playing is retired until it stops.
+void ResourceManager::freeResource(ResourceType type, ResourceHandle handle)
+{
+	switch (type)
+	{
+	case RESOURCE_TEXTURE:
+	{
+		TextureEntry& _entry = m_textures[handle];
+		if (_entry.m_atlased)
+			m_atlas->release(_entry.m_texture, _entry.m_source);
+		else if (_entry.m_texture)
+			SDL_DestroyTexture(_entry.m_texture);
+
+		_entry.m_texture = nullptr;
+		_entry.m_atlased = false;
+		setResidentBytes(type, &_entry.m_residency, 0);
+		break;
+	}
+	case RESOURCE_MUSIC:
+	{
+		MusicEntry& _entry = m_music[handle];
+		if (_entry.m_music && Mix_PlayingMusic() && (m_playingMusic == handle || m_playingMusic == INVALID_HANDLE))
+			m_retiredMusic.push_back(make_pair(_entry.m_music, _entry.m_file));
+		else if (_entry.m_music)
+			Mix_FreeMusic(_entry.m_music);
+
+		if (m_playingMusic == handle)
+			m_playingMusic = INVALID_HANDLE;
+
+		_entry.m_music = nullptr;
+		_entry.m_file = nullptr;
+		setResidentBytes(type, &_entry.m_residency, 0);
+		break;
+	}
+	case RESOURCE_SOUND_EFFECT:
+	{
+		SoundEffectEntry& _entry = m_soundEffects[handle];
+		if (_entry.m_chunk && isChunkPlaying(_entry.m_chunk))
+			m_retiredChunks.push_back(_entry.m_chunk);
+		else if (_entry.m_chunk)
+			Mix_FreeChunk(_entry.m_chunk);
+
+		_entry.m_chunk = nullptr;
+		setResidentBytes(type, &_entry.m_residency, 0);
+		break;
+	}
+	}
+}
+
+ManifestRecord ResourceManager::readJsonRecord(const Value& object, string type)
+{
+	ManifestRecord _record;
+	_record.m_key = object["key"].GetString();
+	_record.m_path = object["path"].GetString();
+
+	if (object.HasMember("priority"))
+		_record.m_priority = parsePriority(object["priority"].GetString());
+
+	// "group" is one name or an array of them
+	if (object.HasMember("group") && object["group"].IsArray())
+	{
+		for (Value::ConstValueIterator _it = object["group"].Begin(); _it != object["group"].End(); ++_it)
+			_record.m_groups.push_back(_it->GetString());
+	}
+	else if (object.HasMember("group"))
+		_record.m_groups.push_back(object["group"].GetString());
+
+	if (type == "music")
+		_record.m_type = RESOURCE_MUSIC;
+	else if (type == "effect")
+		_record.m_type = RESOURCE_SOUND_EFFECT;
+	else if (type == "animation")
+	{
+		_record.m_animated = true;
+		readJsonFrames(object["metaData"], &_record.m_frames);
+	}
+
+	return _record;
+}
+
+ManifestRecord ResourceManager::readXmlRecord(xml_node<>* node, ResourceType type, bool animated)
+{
+	ManifestRecord _record;
+	_record.m_type = type;
+	_record.m_key = node->first_node("key")->value();
+	_record.m_path = node->first_node("path")->value();
+	_record.m_priority = getXmlPriority(node);
+	_record.m_groups = getXmlGroups(node);
+	_record.m_animated = animated;
+
+	if (animated)
+		readXmlFrames(node->first_node("metaData"), &_record.m_frames);
+
+	return _record;
+}
+
+// Reads the next entry of a text manifest, returns false at the end of the file.
+// An entry cut short, as in a manifest saved half way, throws a LoadException.
+bool ResourceManager::readTextRecord(ifstream* file, ManifestRecord* record)
+{
+	string _type;
+	*record = ManifestRecord();
+	if (!(*file >> _type))
+		return false;
+	if (!(*file >> record->m_key >> record->m_path))
+		throw(LoadException("Manifest entry " + _type + " " + record->m_key + " is incomplete\n"));
+
+	record->m_priority = splitTypeToken(&_type, &record->m_groups);
+
+	if (_type == "music")
+		record->m_type = RESOURCE_MUSIC;
+	else if (_type == "sound_effect")
+		record->m_type = RESOURCE_SOUND_EFFECT;
+	else if (_type != "texture")
+	{
+		record->m_animated = true;
+
+		string _line;
+		*file >> _line;
+
+		int _frames = stoi(_line);
+		for (int i = 1; i <= _frames; i++)
+			loadAnimations(file, &record->m_frames);
+
+		if (!*file)
+			throw(LoadException("Frames of manifest entry " + record->m_key + " are incomplete\n"));
+	}
+
+	return true;
+}
+
+bool ResourceManager::readJsonRecords(const string& fileName, vector<ManifestRecord>* records)
+{
+	if (!m_manifestArena.readFile(fileName))
+		return false;
+
+	JsonManifest _manifest(&m_manifestArena);
+	if (_manifest.m_document.HasParseError() || !_manifest.m_document.IsObject() ||
+		!_manifest.m_document.HasMember("resources") || !_manifest.m_document["resources"].IsObject())
+		return false;
+
+	const Value& _resources = _manifest.m_document["resources"];
+	const char* _sections[] = { "textures", "music", "effects", "animations" };
+	const char* _types[] = { "texture", "music", "effect", "animation" };
+
+	// a damaged file is rejected as a whole, never read in part
+	for (int i = 0; i < 4; i++)
+	{
+		if (!_resources.HasMember(_sections[i]) || !_resources[_sections[i]].IsObject())
+			return false;
+
+		const Value& _section = _resources[_sections[i]];
+		for (Value::ConstMemberIterator _it = _section.MemberBegin(); _it != _section.MemberEnd(); ++_it)
+		{
+			if (!isJsonRecord(_it->value, i == 3))
+				return false;
+			records->push_back(readJsonRecord(_it->value, _types[i]));
+		}
+	}
+
+	return true;
+}
+
+bool ResourceManager::readXmlRecords(const string& fileName, vector<ManifestRecord>* records)
+{
+	if (!m_manifestArena.readFile(fileName))
+		return false;
+
+	xml_document<> _document;
+	m_manifestArena.attach(&_document);
+
+	try
+	{
+		_document.parse<0>(m_manifestArena.getText());
+	}
+	catch (parse_error&)
+	{
+		return false;
+	}
+
+	// the sections are read by position, as the loader always has, and a damaged file is rejected as a whole
+	xml_node<>* _root = _document.first_node();
+	xml_node<>* _assets = _root ? _root->first_node("textures") : nullptr;
+	const char* _entries[] = { "texture", "music", "effect", "animation" };
+	const ResourceType _types[] = { RESOURCE_TEXTURE, RESOURCE_MUSIC, RESOURCE_SOUND_EFFECT, RESOURCE_TEXTURE };
+
+	for (int i = 0; i < 4; i++, _assets = _assets->next_sibling())
+	{
+		if (!_assets)
+			return false;
+
+		for (xml_node<>* _node = _assets->first_node(_entries[i]); _node != 0; _node = _node->next_sibling())
+		{
+			if (!isXmlRecord(_node, i == 3))
+				return false;
+			records->push_back(readXmlRecord(_node, _types[i], i == 3));
 		}
 	}
+
+	return true;
+}
+
+bool ResourceManager::readTextRecords(const string& fileName, vector<ManifestRecord>* records)
+{
+	ifstream _myFile(fileName);
+	if (!_myFile.is_open())
+		return false;
+
+	// an entry cut short means the file is still being written
+	try
+	{
+		ManifestRecord _record;
+		while (readTextRecord(&_myFile, &_record))
+			records->push_back(_record);
+	}
+	catch (exception&)
+	{
+		return false;
+	}
+
 	_myFile.close();
+	return true;
+}
+
+bool ResourceManager::readBinaryRecords(const string& fileName, vector<ManifestRecord>* records)
+{
+	BinaryManifest _manifest;
+	if (!_manifest.open(fileName))
+		return false;
+
+	for (unsigned int i = 0; i < _manifest.getEntryCount(); i++)
+	{
+		const ManifestEntry* _entry = _manifest.getEntry(i);
+
+		ManifestRecord _record;
+		_record.m_key = _manifest.getString(_entry->m_keyOffset);
+		_record.m_path = _manifest.getString(_entry->m_pathOffset);
+		_record.m_priority = (ResourcePriority)_entry->m_priority;
+
+		switch (_entry->m_type)
+		{
+		case MANIFEST_MUSIC:
+			_record.m_type = RESOURCE_MUSIC;
+			break;
+		case MANIFEST_SOUND_EFFECT:
+			_record.m_type = RESOURCE_SOUND_EFFECT;
+			break;
+		case MANIFEST_ANIMATION:
+		{
+			const SDL_Rect* _frames = _manifest.getFrames(_entry);
+			_record.m_animated = true;
+			_record.m_frames.assign(_frames, _frames + _entry->m_frameCount);
+			break;
+		}
+		default:
+			break;
+		}
+
+		records->push_back(_record);
+	}
+
+	return true;
+}
+
+void ResourceManager::addManifestRecord(const ManifestRecord& record)
+{
+	addResourceToQueue(record.m_type, record.m_key, record.m_path, record.m_priority, record.m_groups);
+
+	if (record.m_animated)
+		setAnimationFrames(record.m_key, record.m_frames);
+}
+
+// Reads the texture again from the path in its descriptor, which is the texture's own even when
+// an audio entry shares its key
+void ResourceManager::reloadTexture(ResourceHandle handle)
+{
+	TextureEntry& _entry = m_textures[handle];
+	string _key = _entry.m_residency.m_descriptor.m_key;
+	string _path = _entry.m_residency.m_descriptor.m_path;
+
+	MappedFile _file;
+	SDL_Surface* _surface = nullptr;
+	if (_file.open(_path))
+		_surface = IMG_Load_RW(_file.createRWops(), 1);
+	if (_surface == 0)
+		throw(LoadException("Could not load texture " + _key + " from " + _path + "\n" + IMG_GetError() + "\n"));
+
+	// an atlased sprite that kept its size is rewritten in place on its page
+	if (_entry.m_atlased && m_atlas->update(_entry.m_texture, _entry.m_source, _surface))
+	{
+		SDL_FreeSurface(_surface);
+		return;
+	}
+
+	SDL_Texture* _temp = SDL_CreateTextureFromSurface(m_renderer, _surface);
+	SDL_FreeSurface(_surface);
+	if (_temp == 0)
+		throw(LoadException("Could not load texture " + _key + " from " + _path + "\n" + SDL_GetError() + "\n"));
+
+	if (_entry.m_atlased)
+		m_atlas->release(_entry.m_texture, _entry.m_source);
+	else
+		SDL_DestroyTexture(_entry.m_texture);
+
+	Uint32 _format = 0;
+	_entry.m_texture = _temp;
+	_entry.m_source = SDL_Rect();
+	SDL_QueryTexture(_temp, &_format, NULL, &_entry.m_source.w, &_entry.m_source.h);
+	_entry.m_atlased = false;
+	setResidentBytes(RESOURCE_TEXTURE, &_entry.m_residency, (uint64_t)_entry.m_source.w * _entry.m_source.h * SDL_BYTESPERPIXEL(_format));
+	placeAnimationFrames(_key);
+	enforceBudget(RESOURCE_TEXTURE);
+}
+
+// Reads the frames of a JSON animation's metaData into list, replacing what it held
+void ResourceManager::readJsonFrames(const Value& metaData, vector<SDL_Rect>* list)
+{
+	list->clear();
+	for (Value::ConstMemberIterator _it = metaData.MemberBegin(); _it != metaData.MemberEnd(); ++_it)
+	{
+		SDL_Rect _tempRect = SDL_Rect();
+		_tempRect.w = _it->value["width"].GetDouble();
+		_tempRect.h = _it->value["height"].GetDouble();
+		_tempRect.x = _it->value["x"].GetDouble();
+		_tempRect.y = _it->value["y"].GetDouble();
+
+		list->push_back(_tempRect);
+	}
 }
 
-ResourceManager::ResourceManager(){}
\ No newline at end of file
+// Reads the frames of an XML animation's metaData into list, replacing what it held
+void ResourceManager::readXmlFrames(xml_node<>* metaData, vector<SDL_Rect>* list)
+{
+	list->clear();
+	for (xml_node<>* _frame = metaData->first_node("frame"); _frame != 0; _frame = _frame->next_sibling())
+	{
+		SDL_Rect _tempRect = SDL_Rect();
+		_tempRect.w = atoi(_frame->first_node("width")->value());
+		_tempRect.h = atoi(_frame->first_node("height")->value());
+		_tempRect.x = atoi(_frame->first_node("x")->value());
+		_tempRect.y = atoi(_frame->first_node("y")->value());
+
+		list->push_back(_tempRect);
+	}
+}
+
+void ResourceManager::loadAnimations(ifstream* file, vector<SDL_Rect>* list)
+{
+	string _line;
+	*file >> _line;
+	int _width = stoi(_line);
+	*file >> _line;
+	int _height = stoi(_line);
+	*file >> _line;
+	int _x = stoi(_line);
+	*file >> _line;
+	int _y = stoi(_line);
+
+	SDL_Rect _tempRect = SDL_Rect();
+	_tempRect.w = _width;
+	_tempRect.h = _height;
+	_tempRect.x = _x;
+	_tempRect.y = _y;
+
+	list->push_back(_tempRect);
+}
+
+// Re-reads the manifest after it changed on disk and applies only what is different
+void ResourceManager::reloadManifest()
+{
+	vector<ManifestRecord> _records;
+	bool _read = false;
+
+	if (m_source.find(".xml") != string::npos)
+		_read = readXmlRecords(m_source, &_records);
+	else if (m_source.find(".json") != string::npos)
+		_read = readJsonRecords(m_source, &_records);
+	else if (m_source.find(".rman") != string::npos)
+		_read = readBinaryRecords(m_source, &_records);
+	else
+		_read = readTextRecords(m_source, &_records);
+
+	// a manifest saved half way through an edit must not unload everything it no longer parses
+	if (!_read)
+	{
+		cout << "Could not read " << m_source << ", keeping the resources already registered" << endl;
+		return;
+	}
+
+	// a text manifest cut inside its last path still reads, so that path has to name a file
+	if (!_records.empty())
+	{
+		const ManifestRecord& _last = _records.back();
+		Residency* _residency = findResidency(_last.m_type, findResourceHandle(_last.m_type, _last.m_key));
+
+		struct stat _result;
+		bool _known = _residency && _last.m_path == _residency->m_descriptor.m_path;
+		if (!_known && (stat(_last.m_path.c_str(), &_result) != 0 || !(_result.st_mode & S_IFREG)))
+		{
+			cout << _last.m_path << " in " << m_source << " is not a file, keeping the resources already registered" << endl;
+			return;
+		}
+	}
+
+	applyManifest(_records);
+}
+
+// Brings the registry in line with an edited manifest. Every entry is compared, but that is only hash
+// lookups: files are read, decoded or freed for the entries that changed and for nothing else.
+void ResourceManager::applyManifest(const vector<ManifestRecord>& records)
+{
+	// a slot does not record its groups, so they are gathered once up front
+	FlatMap<uint64_t, vector<string>> _groups;
+	for (auto& group : m_groups)
+	{
+		for (auto& member : group.second.m_members)
+			_groups[getSlotId(member.first, member.second)].push_back(group.first);
+	}
+
+	FlatMap<uint64_t, bool> _listed;
+	FlatMap<string, bool> _animated;
+	for (auto& record : records)
+	{
+		ResourceHandle _handle = findResourceHandle(record.m_type, record.m_key);
+		if (_handle != INVALID_HANDLE)
+			_listed[getSlotId(record.m_type, _handle)] = true;
+		if (record.m_animated)
+			_animated[record.m_key] = true;
+	}
+
+	unsigned int _added = 0;
+	unsigned int _removed = 0;
+	unsigned int _changed = 0;
+
+	// removals go first, so a key that changed type is registered afresh below
+	for (auto& resource : m_resourceQueue)
+	{
+		ResourceHandle _handle = findResourceHandle(resource.m_type, resource.m_key);
+		if (_handle == INVALID_HANDLE || _listed.find(getSlotId(resource.m_type, _handle)))
+			continue;
+
+		vector<string>* _current = _groups.find(getSlotId(resource.m_type, _handle));
+		removeResource(resource.m_type, _handle, _current ? *_current : vector<string>());
+		_removed++;
+	}
+
+	// a clip already handed out keeps its frames, new lookups of the key miss
+	vector<string> _staleAnimations;
+	for (auto& animation : m_animationHandles.m_names)
+	{
+		if (!_animated.find(animation.first))
+			_staleAnimations.push_back(animation.first);
+	}
+
+	for (auto& key : _staleAnimations)
+	{
+		if (findHandle(m_animationHandles, key) == m_animationHandles.m_placeholder)
+			m_animationHandles.m_placeholder = INVALID_HANDLE;
+
+		m_animationHandles.m_names.erase(key);
+		m_animationHandles.m_keys.erase(ResourceKey(key).m_hash);
+		_removed++;
+	}
+
+	vector<Resource> _queue;
+	for (auto& record : records)
+	{
+		ResourceHandle _handle = findResourceHandle(record.m_type, record.m_key);
+		bool _changedEntry = false;
+
+		if (_handle == INVALID_HANDLE)
+		{
+			addResourceToQueue(record.m_type, record.m_key, record.m_path, record.m_priority);
+			_handle = findResourceHandle(record.m_type, record.m_key);
+			setResourceGroups(record.m_type, _handle, vector<string>(), record.m_groups);
+
+			// loaded the way loadResourceQueue would have, which is not coming for this one
+			Residency* _residency = findResidency(record.m_type, _handle);
+			_residency->m_reloading = false;
+
+			bool _deferred = m_lazyLoading && record.m_priority != PRIORITY_CRITICAL && record.m_key != "placeholder";
+			if (!_deferred && !_residency->m_grouped)
+				requestDecode(_residency);
+
+			_added++;
+		}
+		else
+		{
+			Residency* _residency = findResidency(record.m_type, _handle);
+
+			if (record.m_path != _residency->m_descriptor.m_path)
+			{
+				moveResource(record.m_type, _handle, record.m_path);
+				_changedEntry = true;
+			}
+
+			if (record.m_priority != _residency->m_descriptor.m_priority)
+			{
+				_residency->m_descriptor.m_priority = record.m_priority;
+				_changedEntry = true;
+			}
+
+			vector<string>* _current = _groups.find(getSlotId(record.m_type, _handle));
+			vector<string> _from = _current ? *_current : vector<string>();
+			vector<string> _to = record.m_groups;
+			sort(_from.begin(), _from.end());
+			sort(_to.begin(), _to.end());
+
+			if (_from != _to)
+			{
+				setResourceGroups(record.m_type, _handle, _from, _to);
+				_changedEntry = true;
+			}
+		}
+
+		if (record.m_animated)
+		{
+			ResourceHandle _animation = findHandle(m_animationHandles, record.m_key);
+			vector<SDL_Rect> _frames = _animation == INVALID_HANDLE ? vector<SDL_Rect>() : getAuthoredFrames(_animation);
+
+			bool _same = _animation != INVALID_HANDLE && _frames.size() == record.m_frames.size() &&
+				equal(_frames.begin(), _frames.end(), record.m_frames.begin(),
+					[](const SDL_Rect& a, const SDL_Rect& b) { return SDL_RectEquals(&a, &b) == SDL_TRUE; });
+
+			if (!_same)
+			{
+				setAnimationFrames(record.m_key, record.m_frames);
+				_changedEntry = true;
+			}
+		}
+
+		if (_changedEntry)
+			_changed++;
+
+		_queue.push_back(findResidency(record.m_type, _handle)->m_descriptor);
+	}
+
+	// later packs and compiled manifests are built from the queue, so it follows the new manifest
+	m_resourceQueue = _queue;
+
+	cout << "Reloaded " << m_source << ": " << _added << " added, " << _removed << " removed, " << _changed << " changed" << endl << endl;
+}
+
+ResourceHandle ResourceManager::findResourceHandle(ResourceType type, const string& key) const
+{
+	switch (type)
+	{
+	case RESOURCE_TEXTURE:
+		return findHandle(m_textureHandles, key);
+	case RESOURCE_MUSIC:
+		return findHandle(m_musicHandles, key);
+	case RESOURCE_SOUND_EFFECT:
+		return findHandle(m_soundEffectHandles, key);
+	}
+
+	return INVALID_HANDLE;
+}
+
+// Moves a resource between groups, taking or dropping the references of the groups that are loaded
+void ResourceManager::setResourceGroups(ResourceType type, ResourceHandle handle, const vector<string>& from,
+	const vector<string>& to)
+{
+	Residency* _residency = findResidency(type, handle);
+	pair<ResourceType, ResourceHandle> _member = make_pair(type, handle);
+
+	for (auto& name : from)
+	{
+		if (find(to.begin(), to.end(), name) != to.end())
+			continue;
+
+		ResourceGroup& _group = m_groups[name];
+		_group.m_members.erase(remove(_group.m_members.begin(), _group.m_members.end(), _member), _group.m_members.end());
+
+		if (_group.m_loaded && _residency->m_references > 0 && --_residency->m_references == 0 && _residency->m_bytes > 0)
+			evict(type, handle);
+	}
+
+	for (auto& name : to)
+	{
+		if (find(from.begin(), from.end(), name) != from.end())
+			continue;
+
+		ResourceGroup& _group = m_groups[name];
+		_group.m_members.push_back(_member);
+
+		if (_group.m_loaded)
+		{
+			_residency->m_references++;
+			requestDecode(_residency);
+		}
+	}
+
+	_residency->m_grouped = !to.empty();
+}
+
+// Points a resource at another file, and reloads it from there if it is resident
+void ResourceManager::moveResource(ResourceType type, ResourceHandle handle, const string& path)
+{
+	Residency* _residency = findResidency(type, handle);
+
+	vector<pair<ResourceType, ResourceHandle>>* _watched = m_watchedResources.find(_residency->m_descriptor.m_path);
+	if (_watched)
+		_watched->erase(remove(_watched->begin(), _watched->end(), make_pair(type, handle)), _watched->end());
+
+	_residency->m_descriptor.m_path = m_strings.store(path);
+	_residency->m_failed = false;
+
+	if (_residency->m_bytes == 0)
+		return;
+
+	watchResource(type, handle);
+
+	// a path that does not load leaves the old texture in place
+	if (type != RESOURCE_TEXTURE)
+		reloadAudio(type, handle);
+	else
+	{
+		try
+		{
+			reloadTexture(handle);
+		}
+		catch (LoadException&)
+		{
+		}
+	}
+}
+
+// Frees a resource the manifest no longer lists and forgets its key
+void ResourceManager::removeResource(ResourceType type, ResourceHandle handle, const vector<string>& groups)
+{
+	setResourceGroups(type, handle, groups, vector<string>());
+
+	Residency* _residency = findResidency(type, handle);
+	string _key = _residency->m_descriptor.m_key;
+	HandleTable* _handles = type == RESOURCE_TEXTURE ? &m_textureHandles :
+		(type == RESOURCE_MUSIC ? &m_musicHandles : &m_soundEffectHandles);
+
+	freeResource(type, handle);
+
+	vector<pair<ResourceType, ResourceHandle>>* _watched = m_watchedResources.find(_residency->m_descriptor.m_path);
+	if (_watched)
+		_watched->erase(remove(_watched->begin(), _watched->end(), make_pair(type, handle)), _watched->end());
+
+	// handles already resolved fall back to the placeholder, new lookups of the key miss
+	if (_handles->m_placeholder == handle)
+		_handles->m_placeholder = INVALID_HANDLE;
+	_handles->m_names.erase(_key);
+	_handles->m_keys.erase(ResourceKey(_key).m_hash);
+
+	*_residency = Residency();
+	cout << "Removed " << _key << endl;
+}
+
+ResourceManager::ResourceManager() :
+m_playingMusic(INVALID_HANDLE),
+m_playingMusicLoops(0),
+m_useClock(0),
+m_peakBytes(0),
+m_lazyLoading(false),
+m_textureHandles("texture"),
+m_musicHandles("music"),
+m_soundEffectHandles("sound effect"),
+m_animationHandles("animation"),
+m_resourcesLoaded(0),
+m_watcher(MAX_DELAY),
+m_renderer(nullptr),
+m_frameBudget(0),
+m_decodesInFlight(0)
+{
+	for (int i = RESOURCE_TEXTURE; i <= RESOURCE_SOUND_EFFECT; i++)
+	{
+		m_memoryBudgets[i] = 0;
+		m_residentBytes[i] = 0;
+	}
+}
\ No newline at end of file
@@ -5,7 +5,10 @@
 #include <fstream>
 #include <vector>
 #include <map>
+#include <deque>
+#include <algorithm>
 #include <time.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <rapidjson\document.h>
 #include <rapidjson\filereadstream.h>
@@ -15,6 +18,18 @@
 #include "rapidxml_iterators.hpp"
 
 #include "Resource.h"
+#include "StringArena.h"
+#include "ResourceKey.h"
+#include "FlatMap.h"
+#include "ManifestArena.h"
+#include "ThreadPool.h"
+#include "LoadHandle.h"
+#include "MappedFile.h"
+#include "ResourcePack.h"
+#include "BinaryManifest.h"
+#include "TextureCache.h"
+#include "TextureAtlas.h"
+#include "FileWatcher.h"
 #include "SDL_image.h"
 #include "SDL_mixer.h"
 
@@ -28,33 +43,282 @@ struct LoadException : public std::exception
 	~LoadException() throw () {}
 };
 
-inline bool doesFileExists(const string& name)
+// Index of a resource in one of the ResourceManager's dense slot arrays.
+// Resolve a key once, then look the resource up by handle every frame.
+typedef unsigned int ResourceHandle;
+const ResourceHandle INVALID_HANDLE = 0xFFFFFFFF;
+
+// A key that was looked up but is not in any loaded manifest
+struct KeyMiss
+{
+	KeyMiss() : m_kind(""), m_count(0) {}
+
+	string			m_key;			// The hash in hex when only a ResourceKey was ever looked up
+	const char*		m_kind;
+	unsigned int	m_count;
+};
+
+// Maps the keys of one resource type to their slots
+struct HandleTable
+{
+	HandleTable(const char* kind) : m_kind(kind), m_placeholder(INVALID_HANDLE) {}
+
+	const char*							m_kind;
+	FlatMap<string, ResourceHandle>		m_names;
+	FlatMap<uint64_t, ResourceHandle>	m_keys;			// The same handles, by hashed key
+	FlatMap<uint64_t, KeyMiss>			m_misses;		// Keys looked up and not found, by hashed key
+	ResourceHandle						m_placeholder;
+};
+
+// A texture as it should be drawn: a whole texture, or one region of an atlas page
+struct Sprite
+{
+	SDL_Texture*	m_texture;
+	SDL_Rect		m_source;
+};
+
+// What the ResourceManager knows about one slot when deciding what to evict
+struct Residency
+{
+	Residency() : m_descriptor(), m_references(0), m_lastUsed(0), m_bytes(0), m_charged(true), m_reloading(false), m_failed(false), m_grouped(false) {}
+
+	Resource		m_descriptor;	// How to load the resource again, m_key is null until it is queued
+	unsigned int	m_references;	// Referenced resources are never evicted
+	uint64_t		m_lastUsed;		// The use clock when the resource was last looked up
+	uint64_t		m_bytes;		// Zero while the resource is not resident
+	bool			m_charged;		// m_bytes counts against the budget, false for an atlased sprite as its page is charged
+	bool			m_reloading;	// Evicted, and being decoded again after a lookup
+	bool			m_failed;		// The last decode failed, lookups wait for the file to change
+	bool			m_grouped;		// Loaded by loadGroup instead of with the rest of the queue
+
+	bool			needsDecode() const { return m_bytes == 0 && !m_reloading && !m_failed && m_descriptor.m_key; }
+};
+
+// The resources a manifest tagged with one group name, such as a level or the UI
+struct ResourceGroup
+{
+	ResourceGroup() : m_loaded(false) {}
+
+	vector<pair<ResourceType, ResourceHandle>>	m_members;
+	bool										m_loaded;	// Holds a reference on every member while set
+};
+
+struct TextureEntry
+{
+	SDL_Texture*	m_texture;
+	SDL_Rect		m_source;
+	bool			m_atlased;		// m_texture is an atlas page owned by the TextureAtlas
+	Residency		m_residency;
+};
+
+struct MusicEntry
+{
+	MusicEntry() : m_music(nullptr) {}
+
+	Mix_Music*				m_music;
+	shared_ptr<MappedFile>	m_file;		// Music streams from its mapping while it plays
+	Residency				m_residency;
+};
+
+struct SoundEffectEntry
+{
+	SoundEffectEntry() : m_chunk(nullptr) {}
+
+	Mix_Chunk*				m_chunk;
+	Residency				m_residency;
+};
+
+// A range of the ResourceManager's frame arena
+struct AnimationEntry
+{
+	AnimationEntry() : m_firstFrame(0), m_frameCount(0), m_texture(INVALID_HANDLE) {}
+
+	unsigned int			m_firstFrame;
+	unsigned int			m_frameCount;
+	ResourceHandle			m_texture;	// The sprite sheet, registered under the same key
+};
+
+// A view of one animation: its texture and its frames, already placed on the
+// texture's atlas page. Valid until the next manifest is loaded or reloaded.
+struct AnimationClip
+{
+	SDL_Texture*			m_texture;
+	const SDL_Rect*			m_frames;
+	unsigned int			m_frameCount;
+
+	const SDL_Rect&			getFrame(unsigned int index) const;	// An empty clip returns an empty rect
+};
+
+inline const SDL_Rect& AnimationClip::getFrame(unsigned int index) const
+{
+	static const SDL_Rect _empty = { 0, 0, 0, 0 };
+	if (m_frameCount == 0)
+		return _empty;
+
+	return m_frames[index % m_frameCount];
+}
+
+// One resident resource in a ResourceStats snapshot
+struct ResourceUsage
 {
-	ifstream _ifs(name.c_str());
-	if (_ifs.good())
+	const char*				m_key;
+	ResourceType			m_type;
+	uint64_t				m_bytes;
+};
+
+// What the ResourceManager holds in memory at the moment getStats() was called
+struct ResourceStats
+{
+	ResourceStats() : m_atlasBytes(0), m_totalBytes(0), m_peakBytes(0)
 	{
-		_ifs.close();
-		return true;
+		for (int i = RESOURCE_TEXTURE; i <= RESOURCE_SOUND_EFFECT; i++)
+		{
+			m_bytes[i] = 0;
+			m_resident[i] = 0;
+		}
 	}
-	else
-	{
-		_ifs.close();
+
+	uint64_t				m_bytes[RESOURCE_SOUND_EFFECT + 1];		// Atlased sprites are left out, their pages are in m_atlasBytes
+	unsigned int			m_resident[RESOURCE_SOUND_EFFECT + 1];
+	uint64_t				m_atlasBytes;	// Every atlas page, however full
+	uint64_t				m_totalBytes;
+	uint64_t				m_peakBytes;	// The most held at once since the ResourceManager was created
+	vector<ResourceUsage>	m_largest;		// Largest first
+};
+
+// The result of reading and decoding one queued resource on a worker thread.
+// Only one of the asset pointers is set, depending on the resource type.
+struct DecodedResource
+{
+	DecodedResource() : resource(), surface(nullptr), music(nullptr), soundEffect(nullptr), dataSize(0), hotReload(false) {}
+
+	Resource				resource;
+	SDL_Surface*			surface;
+	CachedTexture			cachedTexture;	// Set instead of surface on a texture cache hit
+	Mix_Music*				music;
+	shared_ptr<MappedFile>	musicFile;		// Music streams from its mapping while it plays
+	Mix_Chunk*				soundEffect;
+	size_t					dataSize;		// Bytes read from the file or pack
+	bool					hotReload;		// The file changed on disk, so it is read from there even when a pack is open
+	string					error;
+};
+
+// One manifest entry as written, compared against what is registered when the manifest is edited
+struct ManifestRecord
+{
+	ManifestRecord() : m_type(RESOURCE_TEXTURE), m_priority(PRIORITY_NORMAL), m_animated(false) {}
+
+	ResourceType			m_type;
+	string					m_key;
+	string					m_path;
+	ResourcePriority		m_priority;
+	vector<string>			m_groups;
+	bool					m_animated;		// Also an animation, whose frames are in m_frames
+	vector<SDL_Rect>		m_frames;
+};
+
+// Reads the optional <priority> child of an XML manifest entry
+inline ResourcePriority getXmlPriority(xml_node<>* node)
+{
+	xml_node<>* _priority = node->first_node("priority");
+	return _priority ? parsePriority(_priority->value()) : PRIORITY_NORMAL;
+}
+
+// Reads the optional <group> children of an XML manifest entry
+inline vector<string> getXmlGroups(xml_node<>* node)
+{
+	vector<string> _groups;
+	for (xml_node<>* _group = node->first_node("group"); _group != 0; _group = _group->next_sibling("group"))
+		_groups.push_back(_group->value());
+	return _groups;
+}
+
+// Whether an XML manifest entry has every node readXmlRecord reads
+inline bool isXmlRecord(xml_node<>* node, bool animated)
+{
+	if (!node->first_node("key") || !node->first_node("path"))
+		return false;
+	if (!animated)
+		return true;
+
+	xml_node<>* _metaData = node->first_node("metaData");
+	if (!_metaData)
 		return false;
+
+	for (xml_node<>* _frame = _metaData->first_node("frame"); _frame != 0; _frame = _frame->next_sibling())
+	{
+		if (!_frame->first_node("width") || !_frame->first_node("height") || !_frame->first_node("x") || !_frame->first_node("y"))
+			return false;
 	}
+
+	return true;
 }
 
-inline bool isOutOfDate(tm td1, tm td2)
+// Whether a JSON manifest entry has every member readJsonRecord reads, with the types it reads them as
+inline bool isJsonRecord(const Value& object, bool animated)
 {
-	if (td1.tm_sec != td2.tm_sec ||
-		td1.tm_min != td2.tm_min ||
-		td1.tm_hour != td2.tm_hour)
+	if (!object.IsObject() || !object.HasMember("key") || !object["key"].IsString() || !object.HasMember("path") || !object["path"].IsString())
+		return false;
+	if (object.HasMember("priority") && !object["priority"].IsString())
+		return false;
+
+	if (object.HasMember("group") && object["group"].IsArray())
 	{
+		for (Value::ConstValueIterator _it = object["group"].Begin(); _it != object["group"].End(); ++_it)
+		{
+			if (!_it->IsString())
+				return false;
+		}
+	}
+	else if (object.HasMember("group") && !object["group"].IsString())
+		return false;
+
+	if (!animated)
 		return true;
+	if (!object.HasMember("metaData") || !object["metaData"].IsObject())
+		return false;
+
+	const Value& _metaData = object["metaData"];
+	for (Value::ConstMemberIterator _it = _metaData.MemberBegin(); _it != _metaData.MemberEnd(); ++_it)
+	{
+		const Value& _frame = _it->value;
+		if (!_frame.IsObject())
+			return false;
+
+		const char* _fields[] = { "width", "height", "x", "y" };
+		for (auto& field : _fields)
+		{
+			if (!_frame.HasMember(field) || !_frame[field].IsNumber())
+				return false;
+		}
 	}
-	else
+
+	return true;
+}
+
+// Splits a text manifest type token such as "texture:critical@level1,ui" into its type, priority and groups
+inline ResourcePriority splitTypeToken(string* type, vector<string>* groups = nullptr)
+{
+	size_t _groupSeparator = type->find('@');
+	if (_groupSeparator != string::npos)
 	{
-		return false;
+		if (groups)
+		{
+			stringstream _groups(type->substr(_groupSeparator + 1));
+			string _group;
+			while (getline(_groups, _group, ','))
+				groups->push_back(_group);
+		}
+		type->erase(_groupSeparator);
 	}
+
+	size_t _separator = type->find(':');
+	if (_separator == string::npos)
+		return PRIORITY_NORMAL;
+
+	ResourcePriority _priority = parsePriority(type->substr(_separator + 1));
+	type->erase(_separator);
+	return _priority;
 }
 
 class ResourceManager
@@ -66,58 +330,229 @@ public:
 
 	void									init(SDL_Renderer* renderer);
 	void									destroy();
-	void									update(float dt);
+	void									update();
 	
-	SDL_Texture*							getTextureByKey(string key);
-	Mix_Music*								getMusicByKey(string key);
-	Mix_Chunk*								getSoundEffectByKey(string key);
+	ResourceHandle							getTextureHandle(const string& key);
+	ResourceHandle							getMusicHandle(const string& key);
+	ResourceHandle							getSoundEffectHandle(const string& key);
+	ResourceHandle							getAnimationHandle(const string& key);
+
+	ResourceHandle							getTextureHandle(ResourceKey key);
+	ResourceHandle							getMusicHandle(ResourceKey key);
+	ResourceHandle							getSoundEffectHandle(ResourceKey key);
+	ResourceHandle							getAnimationHandle(ResourceKey key);
 
-	pair<SDL_Texture*, vector<SDL_Rect>>	getAnimationByKey(string key);
+	SDL_Texture*							getTexture(ResourceHandle handle);	// Atlased textures return their whole page
+	Sprite									getSprite(ResourceHandle handle);
+	Mix_Music*								getMusic(ResourceHandle handle);
+	Mix_Chunk*								getSoundEffect(ResourceHandle handle);
+	AnimationClip							getAnimation(ResourceHandle handle);
+
+	SDL_Texture*							getTextureByKey(const string& key);
+	Sprite									getSpriteByKey(const string& key);
+	Mix_Music*								getMusicByKey(const string& key);
+	Mix_Chunk*								getSoundEffectByKey(const string& key);
+
+	AnimationClip							getAnimationByKey(const string& key);
+
+	SDL_Texture*							getTextureByKey(ResourceKey key);
+	Sprite									getSpriteByKey(ResourceKey key);
+	Mix_Music*								getMusicByKey(ResourceKey key);
+	Mix_Chunk*								getSoundEffectByKey(ResourceKey key);
+	AnimationClip							getAnimationByKey(ResourceKey key);
 
 	void									loadResourcesFromText(string fileName);
 	void									loadResourcesFromJSON(string fileName);
 	void									loadResourcesFromXML(string fileName);
+	void									loadResourcesFromPack(string fileName);
+	void									loadResourcesFromBinary(string fileName);
+	void									loadResourcesFromManifest(string fileName);
+
+	bool									buildPack(string manifestFile, string packFile);
+	bool									compileManifest(string manifestFile, string binaryFile);
 
 	void									loadResourceQueue();
+	LoadHandle								loadResourceQueueAsync();
+	LoadHandle								loadResourceQueueIncremental();
+
+	void									setLazyLoading(bool lazy);	// Only placeholders and critical resources load up front
+	bool									isLazyLoading() const;
+	LoadHandle								prefetch(const vector<string>& keys);
+
+	LoadHandle								loadGroup(const string& name);
+	void									unloadGroup(const string& name);
+	bool									isGroupLoaded(const string& name) const;
+
+	void									setFrameBudget(float milliseconds);
+	float									getFrameBudget() const;
+	unsigned int							getQueueDepth();
+
+	void									setMemoryBudget(ResourceType type, uint64_t bytes);	// 0 removes the budget
+	uint64_t								getMemoryBudget(ResourceType type) const;
+	void									acquire(ResourceType type, ResourceHandle handle);
+	void									release(ResourceType type, ResourceHandle handle);
+
+	bool									playMusic(ResourceHandle handle, int loops = -1);	// Lets a hot reload restart the track it replaces
+	ResourceStats							getStats(size_t largestCount = 10);
+
+	vector<KeyMiss>							getMissReport() const;	// Most missed first
+	void									clearMissReport();
+
+	void									enableTextureCache(string directory, uint64_t maxBytes);
+	void									enableTextureAtlas(int pageSize, int maxSpriteSize);
 
 private:
 	static ResourceManager*					m_instance;
 
-	map<string, pair<SDL_Texture*, tm>>		m_textures;
-	map<string, Mix_Music*>					m_music;
-	map<string, Mix_Chunk*>					m_soundEffects;
+	vector<TextureEntry>					m_textures;
+	vector<MusicEntry>						m_music;
+	vector<SoundEffectEntry>				m_soundEffects;
+	vector<AnimationEntry>					m_animations;
+	vector<Mix_Chunk*>						m_retiredChunks;	// Replaced by a hot reload while still playing
+	vector<pair<Mix_Music*, shared_ptr<MappedFile>>>	m_retiredMusic;
+	ResourceHandle							m_playingMusic;		// Started through playMusic
+	int										m_playingMusicLoops;
+	vector<SDL_Rect>						m_authoredFrames;	// Every animation's frames, back to back, as written in the manifest
+	vector<SDL_Rect>						m_frameArena;		// The same frames moved onto their atlas pages
 
-	map<string, vector<SDL_Rect>>			m_animations;
+	uint64_t								m_memoryBudgets[RESOURCE_SOUND_EFFECT + 1];
+	uint64_t								m_residentBytes[RESOURCE_SOUND_EFFECT + 1];
+	uint64_t								m_useClock;
+	uint64_t								m_peakBytes;
+	bool									m_lazyLoading;
 
-	map<string, string>						m_path;
+	HandleTable								m_textureHandles;
+	HandleTable								m_musicHandles;
+	HandleTable								m_soundEffectHandles;
+	HandleTable								m_animationHandles;
+	FlatMap<uint64_t, string>				m_keyNames;		// Every key seen, by hash, to catch collisions
 
-	vector<Resource*>						m_resourceQueue;
+	FlatMap<string, ResourceGroup>			m_groups;
+
+	StringArena								m_strings;		// Keys and paths of queued resources
+	vector<Resource>						m_resourceQueue;
+	ManifestArena							m_manifestArena;
+	shared_ptr<ResourcePack>				m_pack;
+	shared_ptr<TextureCache>				m_textureCache;
+	shared_ptr<TextureAtlas>				m_atlas;
 
 	float									m_resourcesLoaded;
-	float									m_fileCheckDelay;
 	string									m_source;
-	tm										m_sourceTimeInfo;
+	FileWatcher								m_watcher;			// The manifest and every texture file
+	FlatMap<string, vector<pair<ResourceType, ResourceHandle>>>	m_watchedResources;	// By the path they were loaded from
 
 	SDL_Renderer*							m_renderer;
 
-	void									addResourceToQueue(Resource* resource);
-	void									loadResource(Resource* resource);
+	float									m_frameBudget;
+	deque<pair<LoadHandle, Resource>>		m_pendingResources;
 
-	void									addTexture(string key);
-	void									addMusic(string key);
-	void									addSoundEffect(string key);
+	mutex									m_decodedMutex;
+	deque<pair<LoadHandle, shared_ptr<DecodedResource>>>	m_decodedResources;
+	unsigned int							m_decodesInFlight;	// Enqueued on the pool and not picked up yet, game thread only
+	ThreadPool								m_loaderPool;
 
-	void									checkJsonObject(const Value& object, string type);
+	void									addResourceToQueue(ResourceType type, const string& key, const string& path,
+																ResourcePriority priority, const vector<string>& groups = vector<string>());
+	void									addResourceToQueue(ResourceType type, const char* key, const char* path,
+																ResourcePriority priority, const vector<string>& groups = vector<string>());
+	vector<Resource>						getScheduledQueue();
+	LoadHandle								createLoadHandle(const vector<Resource>& schedule);
+	void									decodeResource(DecodedResource* decoded);
+	bool									openResourceData(string key, PackEntryType type, string path, bool packed, shared_ptr<MappedFile>* file,
+																const unsigned char** data, size_t* size);
+	void									loadResource(DecodedResource* decoded);
+	void									abandonDecode(const Resource& resource);
+	void									watchResource(ResourceType type, ResourceHandle handle);
+	void									processDecodedResources(Uint64 frameStart);
+	void									processPendingResources(Uint64 frameStart);
+	bool									isFrameBudgetSpent(Uint64 frameStart);
+	void									freeDecodedResource(DecodedResource* decoded);
 
-	void									reloadTexture(string key);
-	void									loadAnimations(ifstream* file, vector<SDL_Rect>* list);
+	void									addTexture(string key, SDL_Surface* surface);
+	void									addTexture(string key, const CachedTexture& cached);
+	bool									addToAtlas(string key, SDL_Surface* surface);
+	const TextureEntry*						findTextureEntry(ResourceHandle handle);
 
-	tm										getTimeInfo(const char* path);
-	vector<SDL_Rect>						getAnimationFrames(string key);
+	template<typename T>
+	ResourceHandle							reserveHandle(HandleTable* handles, vector<T>* slots, const string& key);
+	template<typename T>
+	ResourceHandle							reserveHandle(HandleTable* handles, vector<T>* slots, const char* key);
+	ResourceHandle							findHandle(const HandleTable& handles, const string& key) const;
+	ResourceHandle							findHandle(const HandleTable& handles, ResourceKey key) const;
+	ResourceKey								registerKey(const char* key, size_t length);
+	ResourceHandle							lookupHandle(HandleTable* handles, const string& key);
+	ResourceHandle							lookupHandle(HandleTable* handles, ResourceKey key);
+	void									recordMiss(HandleTable* handles, ResourceKey key, const string* name);
+	void									setAnimationFrames(const string& key, const vector<SDL_Rect>& frames);
+	void									setAnimationFrames(const char* key, const SDL_Rect* frames, size_t count);
+	void									placeAnimationFrames(const string& key);
+	void									placeAnimationFrames(ResourceHandle animation);
+	vector<SDL_Rect>						getAuthoredFrames(ResourceHandle handle);
+	void									addMusic(string key, Mix_Music* music, shared_ptr<MappedFile> file, size_t size);
+	void									addSoundEffect(string key, Mix_Chunk* soundEffect);
 
-	void									reloadFromXML();
-	void									reloadFromJSON();
-	void									reloadFromText();
+	Residency*								findResidency(ResourceType type, ResourceHandle handle);
+	void									touch(ResourceType type, ResourceHandle handle);
+	bool									requestDecode(Residency* residency, LoadHandle handle = LoadHandle());
+	void									setResidentBytes(ResourceType type, Residency* residency, uint64_t bytes, bool charged = true);
+	void									enforceBudget(ResourceType type);
+	bool									isPlaceholder(ResourceType type, ResourceHandle handle) const;
+	bool									isEvictable(ResourceType type, ResourceHandle handle);
+	bool									evict(ResourceType type, ResourceHandle handle);
+	void									freeResource(ResourceType type, ResourceHandle handle);
+	void									enqueueDecode(LoadHandle handle, const Resource& resource, bool hotReload = false);
+	void									reloadAudio(ResourceType type, ResourceHandle handle);
+	void									freeRetiredAudio(bool all);
+
+	ManifestRecord							readJsonRecord(const Value& object, string type);
+	ManifestRecord							readXmlRecord(xml_node<>* node, ResourceType type, bool animated);
+	bool									readTextRecord(ifstream* file, ManifestRecord* record);
+	bool									readJsonRecords(const string& fileName, vector<ManifestRecord>* records);
+	bool									readXmlRecords(const string& fileName, vector<ManifestRecord>* records);
+	bool									readTextRecords(const string& fileName, vector<ManifestRecord>* records);
+	bool									readBinaryRecords(const string& fileName, vector<ManifestRecord>* records);
+	void									addManifestRecord(const ManifestRecord& record);
+
+	void									reloadTexture(ResourceHandle handle);
+	void									readJsonFrames(const Value& metaData, vector<SDL_Rect>* list);
+	void									readXmlFrames(xml_node<>* metaData, vector<SDL_Rect>* list);
+	void									loadAnimations(ifstream* file, vector<SDL_Rect>* list);
+
+	void									reloadManifest();
+	void									applyManifest(const vector<ManifestRecord>& records);
+	ResourceHandle							findResourceHandle(ResourceType type, const string& key) const;
+	void									setResourceGroups(ResourceType type, ResourceHandle handle, const vector<string>& from,
+																const vector<string>& to);
+	void									moveResource(ResourceType type, ResourceHandle handle, const string& path);
+	void									removeResource(ResourceType type, ResourceHandle handle, const vector<string>& groups);
 
 	ResourceManager();
 };
+
+template<typename T>
+ResourceHandle ResourceManager::reserveHandle(HandleTable* handles, vector<T>* slots, const string& key)
+{
+	return reserveHandle(handles, slots, key.c_str());
+}
+
+// Returns the slot for key, adding an empty one the first time the key is seen.
+// Found by hash, so a key read out of a mapped manifest is only copied when it is new.
+template<typename T>
+ResourceHandle ResourceManager::reserveHandle(HandleTable* handles, vector<T>* slots, const char* key)
+{
+	ResourceKey _key = registerKey(key, strlen(key));
+	ResourceHandle* _handle = handles->m_keys.find(_key.m_hash);
+	if (_handle)
+		return *_handle;
+
+	ResourceHandle _new = slots->size();
+	slots->push_back(T());
+	handles->m_names[key] = _new;
+	handles->m_keys[_key.m_hash] = _new;
+	handles->m_misses.erase(_key.m_hash);
+
+	if (strcmp(key, "placeholder") == 0)
+		handles->m_placeholder = _new;
+
+	return _new;
+}
\ No newline at end of file
@@ -5,9 +5,40 @@
 using namespace std;
 
 #include "Game.h"
+#include "Benchmark.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+	// offline tool: ResourceManagerComponent --pack <manifest> <archive.pak>
+	if (argc == 4 && string(argv[1]) == "--pack")
+	{
+		bool _packed = ResourceManager::getInstance()->buildPack(argv[2], argv[3]);
+		ResourceManager::getInstance()->destroy();
+		return _packed ? 0 : 1;
+	}
+
+	// offline tool: ResourceManagerComponent --compile <manifest> <manifest.rman>
+	if (argc == 4 && string(argv[1]) == "--compile")
+	{
+		bool _compiled = ResourceManager::getInstance()->compileManifest(argv[2], argv[3]);
+		ResourceManager::getInstance()->destroy();
+		return _compiled ? 0 : 1;
+	}
+
+	// ResourceManagerComponent --bench-maps
+	if (argc == 2 && string(argv[1]) == "--bench-maps")
+	{
+		benchmarkMaps();
+		return 0;
+	}
+
+	// ResourceManagerComponent --bench-descriptors
+	if (argc == 2 && string(argv[1]) == "--bench-descriptors")
+	{
+		benchmarkDescriptors();
+		return 0;
+	}
+
 	srand(time(NULL));
 
 	Game game;
@@ -0,0 +1,237 @@
+#include "stdafx.h"
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+#include "ResourcePack.h"
+#include "Hash.h"
+
+const uint64_t PACK_ALIGNMENT = 16;
+
+ResourcePack::ResourcePack() :
+m_header(nullptr),
+m_entries(nullptr),
+m_strings(nullptr)
+{}
+
+bool ResourcePack::open(const string& fileName)
+{
+	close();
+
+	shared_ptr<MappedFile> _file = make_shared<MappedFile>();
+	if (!_file->open(fileName) || _file->getSize() < sizeof(PackHeader))
+		return false;
+
+	const PackHeader* _header = (const PackHeader*)_file->getData();
+	if (memcmp(_header->m_magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || _header->m_version != PACK_VERSION)
+		return false;
+
+	uint64_t _indexEnd = sizeof(PackHeader) + (uint64_t)_header->m_entryCount * sizeof(PackEntry) + _header->m_stringTableSize;
+	if (_indexEnd > _file->getSize())
+		return false;
+
+	const PackEntry* _entries = (const PackEntry*)(_file->getData() + sizeof(PackHeader));
+	const char* _strings = (const char*)(_entries + _header->m_entryCount);
+
+	// the last string must end inside the table, so no string read from it can run past the end
+	if (_header->m_stringTableSize > 0 && _strings[_header->m_stringTableSize - 1] != '\0')
+		return false;
+
+	// a truncated or corrupt archive is refused here, instead of reading outside the mapping later
+	for (uint32_t i = 0; i < _header->m_entryCount; i++)
+	{
+		const PackEntry& _entry = _entries[i];
+		if (_entry.m_keyOffset >= _header->m_stringTableSize || _entry.m_pathOffset >= _header->m_stringTableSize ||
+			_entry.m_offset > _file->getSize() || _entry.m_size > _file->getSize() - _entry.m_offset ||
+			_entry.m_type > PACK_FRAMES)
+		{
+			return false;
+		}
+	}
+
+	m_file = _file;
+	m_header = _header;
+	m_entries = _entries;
+	m_strings = _strings;
+
+	return true;
+}
+
+void ResourcePack::close()
+{
+	m_file = nullptr;
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_strings = nullptr;
+}
+
+unsigned int ResourcePack::getEntryCount() const
+{
+	return m_header ? m_header->m_entryCount : 0;
+}
+
+const PackEntry* ResourcePack::getEntry(unsigned int index) const
+{
+	return &m_entries[index];
+}
+
+const PackEntry* ResourcePack::find(const string& key, PackEntryType type) const
+{
+	unsigned int _low = 0;
+	unsigned int _high = getEntryCount();
+
+	while (_low < _high)
+	{
+		unsigned int _middle = (_low + _high) / 2;
+		const PackEntry* _entry = &m_entries[_middle];
+
+		int _compare = strcmp(getString(_entry->m_keyOffset), key.c_str());
+		if (_compare == 0)
+			_compare = (int)_entry->m_type - (int)type;
+
+		if (_compare == 0)
+			return _entry;
+		else if (_compare < 0)
+			_low = _middle + 1;
+		else
+			_high = _middle;
+	}
+
+	return nullptr;
+}
+
+const char* ResourcePack::getString(uint32_t offset) const
+{
+	return m_strings + offset;
+}
+
+const unsigned char* ResourcePack::getData(const PackEntry* entry) const
+{
+	return m_file->getData() + entry->m_offset;
+}
+
+// Offsets and sizes were checked by open, this catches corrupted data
+bool ResourcePack::verify(const PackEntry* entry) const
+{
+	return crc32(getData(entry), (size_t)entry->m_size) == entry->m_checksum;
+}
+
+shared_ptr<MappedFile> ResourcePack::getFile() const
+{
+	return m_file;
+}
+
+bool ResourcePack::build(const string& fileName, const vector<PackSource>& sources)
+{
+	// sort by key then type to match the binary search in find
+	vector<const PackSource*> _sorted;
+	for (auto& source : sources)
+		_sorted.push_back(&source);
+
+	stable_sort(_sorted.begin(), _sorted.end(), [](const PackSource* a, const PackSource* b)
+	{
+		if (a->m_key != b->m_key)
+			return a->m_key < b->m_key;
+		return a->m_type < b->m_type;
+	});
+
+	// map every source file up front so the index can be written in one go
+	vector<shared_ptr<MappedFile>> _files;
+	vector<const PackSource*> _included;
+	for (auto& source : _sorted)
+	{
+		shared_ptr<MappedFile> _file;
+		if (source->m_type != PACK_FRAMES)
+		{
+			_file = make_shared<MappedFile>();
+			if (!_file->open(source->m_path))
+			{
+				cout << "Skipping " + source->m_key + ", could not read " + source->m_path << endl;
+				continue;
+			}
+		}
+
+		_files.push_back(_file);
+		_included.push_back(source);
+	}
+
+	string _strings;
+	vector<PackEntry> _entries(_included.size());
+	vector<vector<int32_t>> _frameData(_included.size());
+
+	for (size_t i = 0; i < _included.size(); i++)
+	{
+		const PackSource* _source = _included[i];
+		PackEntry& _entry = _entries[i];
+
+		_entry.m_keyOffset = _strings.size();
+		_strings.append(_source->m_key.c_str(), _source->m_key.size() + 1);
+		_entry.m_pathOffset = _strings.size();
+		_strings.append(_source->m_path.c_str(), _source->m_path.size() + 1);
+
+		_entry.m_type = (uint16_t)_source->m_type;
+		_entry.m_priority = (uint16_t)_source->m_priority;
+
+		if (_source->m_type == PACK_FRAMES)
+		{
+			for (auto& frame : _source->m_frames)
+			{
+				_frameData[i].push_back(frame.x);
+				_frameData[i].push_back(frame.y);
+				_frameData[i].push_back(frame.w);
+				_frameData[i].push_back(frame.h);
+			}
+			_entry.m_size = _frameData[i].size() * sizeof(int32_t);
+			_entry.m_checksum = crc32(_frameData[i].data(), (size_t)_entry.m_size);
+		}
+		else
+		{
+			_entry.m_size = _files[i]->getSize();
+			_entry.m_checksum = crc32(_files[i]->getData(), (size_t)_entry.m_size);
+		}
+	}
+
+	uint64_t _offset = sizeof(PackHeader) + _entries.size() * sizeof(PackEntry) + _strings.size();
+	for (auto& entry : _entries)
+	{
+		_offset = (_offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+		entry.m_offset = _offset;
+		_offset += entry.m_size;
+	}
+
+	FILE* _file = nullptr;
+	fopen_s(&_file, fileName.c_str(), "wb");
+	if (_file == nullptr)
+		return false;
+
+	PackHeader _header = PackHeader();
+	memcpy(_header.m_magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+	_header.m_version = PACK_VERSION;
+	_header.m_entryCount = _entries.size();
+	_header.m_stringTableSize = _strings.size();
+
+	fwrite(&_header, sizeof(_header), 1, _file);
+	if (!_entries.empty())
+		fwrite(_entries.data(), sizeof(PackEntry), _entries.size(), _file);
+	fwrite(_strings.data(), 1, _strings.size(), _file);
+
+	uint64_t _written = sizeof(PackHeader) + _entries.size() * sizeof(PackEntry) + _strings.size();
+	for (size_t i = 0; i < _entries.size(); i++)
+	{
+		static const char _padding[PACK_ALIGNMENT] = { 0 };
+		fwrite(_padding, 1, (size_t)(_entries[i].m_offset - _written), _file);
+
+		if (_included[i]->m_type == PACK_FRAMES)
+			fwrite(_frameData[i].data(), 1, (size_t)_entries[i].m_size, _file);
+		else
+			fwrite(_files[i]->getData(), 1, (size_t)_entries[i].m_size, _file);
+
+		_written = _entries[i].m_offset + _entries[i].m_size;
+	}
+
+	bool _success = ferror(_file) == 0;
+	fclose(_file);
+
+	cout << "Packed " + to_string(_entries.size()) + " entries into " + fileName << endl;
+	return _success;
+}
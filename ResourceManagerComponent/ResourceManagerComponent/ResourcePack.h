@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+#include "SDL_rect.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+// A .pak archive stores every asset of a manifest in one file:
+//
+//   PackHeader | PackEntry[entryCount] | string table | data...
+//
+// Entries are sorted by key then type so lookups can binary search the
+// mapped index in place. Every data block starts on a 16 byte boundary.
+
+const char PACK_MAGIC[4] = { 'R', 'P', 'A', 'K' };
+const uint32_t PACK_VERSION = 1;
+
+enum PackEntryType
+{
+	PACK_TEXTURE,
+	PACK_MUSIC,
+	PACK_SOUND_EFFECT,
+	PACK_FRAMES						// Animation frames as int32 x, y, w, h
+};
+
+struct PackHeader
+{
+	char		m_magic[4];
+	uint32_t	m_version;
+	uint32_t	m_entryCount;
+	uint32_t	m_stringTableSize;
+};
+
+struct PackEntry
+{
+	uint32_t	m_keyOffset;		// Into the string table, null terminated
+	uint32_t	m_pathOffset;		// The file the entry was built from
+	uint64_t	m_offset;			// From the start of the archive
+	uint64_t	m_size;
+	uint16_t	m_type;
+	uint16_t	m_priority;
+	uint32_t	m_checksum;			// CRC-32 of the data
+};
+
+// One asset to write into an archive. Files are read from m_path, frame
+// tables are written from m_frames.
+struct PackSource
+{
+	string				m_key;
+	string				m_path;
+	PackEntryType		m_type;
+	int					m_priority;
+	vector<SDL_Rect>	m_frames;
+};
+
+class ResourcePack
+{
+public:
+	ResourcePack();
+
+	bool									open(const string& fileName);
+	void									close();
+
+	unsigned int							getEntryCount() const;
+	const PackEntry*						getEntry(unsigned int index) const;
+	const PackEntry*						find(const string& key, PackEntryType type) const;
+
+	const char*								getString(uint32_t offset) const;
+	const unsigned char*					getData(const PackEntry* entry) const;
+	bool									verify(const PackEntry* entry) const;
+
+	shared_ptr<MappedFile>					getFile() const;
+
+	static bool								build(const string& fileName, const vector<PackSource>& sources);
+
+private:
+	shared_ptr<MappedFile>					m_file;
+	const PackHeader*						m_header;
+	const PackEntry*						m_entries;
+	const char*								m_strings;
+};
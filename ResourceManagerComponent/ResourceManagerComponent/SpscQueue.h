@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <utility>
+
+using namespace std;
+
+// A bounded lock-free queue between exactly one producer thread and one
+// consumer thread. Each side only writes its own index, so neither ever
+// waits on the other; push fails instead of blocking when the queue is full.
+template<typename T>
+class SpscQueue
+{
+public:
+	SpscQueue(size_t capacity) : m_head(0), m_tail(0)
+	{
+		size_t _capacity = 1;
+		while (_capacity < capacity)
+			_capacity *= 2;
+
+		m_slots.resize(_capacity);
+		m_mask = _capacity - 1;
+	}
+
+	// Producer only
+	bool push(T value)
+	{
+		size_t _tail = m_tail.load(memory_order_relaxed);
+		if (_tail - m_head.load(memory_order_acquire) == m_slots.size())
+			return false;
+
+		m_slots[_tail & m_mask] = move(value);
+		m_tail.store(_tail + 1, memory_order_release);
+		return true;
+	}
+
+	// Consumer only
+	bool pop(T* value)
+	{
+		size_t _head = m_head.load(memory_order_relaxed);
+		if (_head == m_tail.load(memory_order_acquire))
+			return false;
+
+		*value = move(m_slots[_head & m_mask]);
+		m_head.store(_head + 1, memory_order_release);
+		return true;
+	}
+
+private:
+	vector<T>					m_slots;
+	size_t						m_mask;
+
+	// padded apart so the two threads do not keep stealing each other's cache line
+	atomic<size_t>				m_head;		// Next slot to pop, written by the consumer
+	char						m_padding[64 - sizeof(atomic<size_t>)];
+	atomic<size_t>				m_tail;		// Next slot to push, written by the producer
+
+	SpscQueue(const SpscQueue&);
+	SpscQueue&					operator=(const SpscQueue&);
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "stdafx.h"
+#include "StringArena.h"
+#include <string.h>
+
+StringArena::StringArena(size_t blockSize) :
+m_blockSize(blockSize),
+m_used(blockSize)
+{}
+
+const char* StringArena::store(const char* text, size_t length)
+{
+	size_t _size = length + 1;
+
+	// strings too long for a block get one of their own, slotted in behind the open block
+	if (_size > m_blockSize)
+	{
+		unique_ptr<char[]> _own(new char[_size]);
+		char* _string = _own.get();
+		memcpy(_string, text, length);
+		_string[length] = '\0';
+		m_blocks.insert(m_blocks.empty() ? m_blocks.end() : m_blocks.end() - 1, move(_own));
+		return _string;
+	}
+
+	if (m_used + _size > m_blockSize)
+	{
+		m_blocks.push_back(unique_ptr<char[]>(new char[m_blockSize]));
+		m_used = 0;
+	}
+
+	char* _string = m_blocks.back().get() + m_used;
+	memcpy(_string, text, length);
+	_string[length] = '\0';
+	m_used += _size;
+	return _string;
+}
+
+const char* StringArena::store(const string& text)
+{
+	return store(text.data(), text.size());
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+
+using namespace std;
+
+// Append-only storage for short strings such as resource keys and paths.
+// Strings are packed into large blocks, so storing one rarely allocates, and
+// a stored string never moves, so its pointer stays valid for the arena's
+// lifetime and can be read from other threads.
+class StringArena
+{
+public:
+	StringArena(size_t blockSize = 64 * 1024);
+
+	const char*								store(const char* text, size_t length);
+	const char*								store(const string& text);
+
+private:
+	vector<unique_ptr<char[]>>				m_blocks;
+	size_t									m_blockSize;
+	size_t									m_used;		// Bytes used in the newest block
+};
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "stdafx.h"
+#include "TextureAtlas.h"
+
+// space left around every sprite so filtering never samples a neighbour
+const int ATLAS_PADDING = 1;
+const Uint32 ATLAS_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+
+TextureAtlas::TextureAtlas(SDL_Renderer* renderer, int pageSize, int maxSpriteSize) :
+m_renderer(renderer),
+m_pageSize(pageSize),
+m_maxSpriteSize(maxSpriteSize)
+{}
+
+TextureAtlas::~TextureAtlas()
+{
+	for (auto& page : m_pages)
+		SDL_DestroyTexture(page.m_texture);
+	m_pages.clear();
+}
+
+bool TextureAtlas::canPack(int width, int height) const
+{
+	return width <= m_maxSpriteSize && height <= m_maxSpriteSize &&
+		width + ATLAS_PADDING * 2 <= m_pageSize && height + ATLAS_PADDING * 2 <= m_pageSize;
+}
+
+bool TextureAtlas::pack(SDL_Surface* surface, SDL_Texture** page, SDL_Rect* source)
+{
+	if (!canPack(surface->w, surface->h))
+		return false;
+
+	Page* _target = nullptr;
+	for (auto& existing : m_pages)
+	{
+		if (allocate(&existing, surface->w, surface->h, source))
+		{
+			_target = &existing;
+			break;
+		}
+	}
+
+	if (_target == nullptr)
+	{
+		if (!addPage() || !allocate(&m_pages.back(), surface->w, surface->h, source))
+			return false;
+		_target = &m_pages.back();
+	}
+
+	*page = _target->m_texture;
+	return update(*page, *source, surface);
+}
+
+bool TextureAtlas::update(SDL_Texture* page, const SDL_Rect& source, SDL_Surface* surface)
+{
+	if (surface->w != source.w || surface->h != source.h)
+		return false;
+
+	// pages are all one format, convert anything else on the way in
+	SDL_Surface* _converted = surface;
+	if (surface->format->format != ATLAS_FORMAT)
+	{
+		_converted = SDL_ConvertSurfaceFormat(surface, ATLAS_FORMAT, 0);
+		if (_converted == nullptr)
+			return false;
+	}
+
+	SDL_LockSurface(_converted);
+	bool _updated = SDL_UpdateTexture(page, &source, _converted->pixels, _converted->pitch) == 0;
+	SDL_UnlockSurface(_converted);
+
+	if (_converted != surface)
+		SDL_FreeSurface(_converted);
+
+	return _updated;
+}
+
+void TextureAtlas::release(SDL_Texture* page, const SDL_Rect& source)
+{
+	for (auto& existing : m_pages)
+	{
+		if (existing.m_texture != page)
+			continue;
+
+		SDL_Rect _slot = source;
+		_slot.x -= ATLAS_PADDING;
+		_slot.y -= ATLAS_PADDING;
+		_slot.w += ATLAS_PADDING * 2;
+		_slot.h += ATLAS_PADDING * 2;
+
+		// cleared so a smaller sprite moving in never has the old one's pixels in its padding
+		vector<Uint32> _clear(_slot.w * _slot.h, 0);
+		SDL_UpdateTexture(page, &_slot, _clear.data(), _slot.w * sizeof(Uint32));
+
+		existing.m_freeSlots.push_back(_slot);
+		return;
+	}
+}
+
+unsigned int TextureAtlas::getPageCount() const
+{
+	return m_pages.size();
+}
+
+uint64_t TextureAtlas::getBytes() const
+{
+	return (uint64_t)m_pages.size() * m_pageSize * m_pageSize * SDL_BYTESPERPIXEL(ATLAS_FORMAT);
+}
+
+bool TextureAtlas::allocate(Page* page, int width, int height, SDL_Rect* source)
+{
+	int _width = width + ATLAS_PADDING * 2;
+	int _height = height + ATLAS_PADDING * 2;
+
+	// a released slot is reused under the same rule as a shelf
+	for (size_t i = 0; i < page->m_freeSlots.size(); i++)
+	{
+		const SDL_Rect& _slot = page->m_freeSlots[i];
+		if (_width <= _slot.w && _height <= _slot.h && _height * 2 >= _slot.h)
+		{
+			source->x = _slot.x + ATLAS_PADDING;
+			source->y = _slot.y + ATLAS_PADDING;
+			source->w = width;
+			source->h = height;
+			page->m_freeSlots.erase(page->m_freeSlots.begin() + i);
+			return true;
+		}
+	}
+
+	// first shelf that is tall enough without wasting more than half of it
+	for (auto& shelf : page->m_shelves)
+	{
+		if (_height <= shelf.m_height && _height * 2 >= shelf.m_height && shelf.m_x + _width <= m_pageSize)
+		{
+			source->x = shelf.m_x + ATLAS_PADDING;
+			source->y = shelf.m_y + ATLAS_PADDING;
+			source->w = width;
+			source->h = height;
+			shelf.m_x += _width;
+			return true;
+		}
+	}
+
+	if (page->m_nextShelfY + _height > m_pageSize)
+		return false;
+
+	Shelf _shelf;
+	_shelf.m_y = page->m_nextShelfY;
+	_shelf.m_height = _height;
+	_shelf.m_x = _width;
+	page->m_shelves.push_back(_shelf);
+	page->m_nextShelfY += _height;
+
+	source->x = ATLAS_PADDING;
+	source->y = _shelf.m_y + ATLAS_PADDING;
+	source->w = width;
+	source->h = height;
+	return true;
+}
+
+bool TextureAtlas::addPage()
+{
+	Page _page;
+	_page.m_texture = SDL_CreateTexture(m_renderer, ATLAS_FORMAT, SDL_TEXTUREACCESS_STATIC, m_pageSize, m_pageSize);
+	_page.m_nextShelfY = 0;
+
+	if (_page.m_texture == nullptr)
+		return false;
+
+	// start fully transparent so padding never shows
+	vector<Uint32> _clear(m_pageSize * m_pageSize, 0);
+	SDL_UpdateTexture(_page.m_texture, NULL, _clear.data(), m_pageSize * sizeof(Uint32));
+	SDL_SetTextureBlendMode(_page.m_texture, SDL_BLENDMODE_BLEND);
+
+	m_pages.push_back(_page);
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "SDL_render.h"
+
+using namespace std;
+
+// Packs small textures into large shared pages so sprites drawn together
+// come from the same SDL_Texture. Sprites are copied straight into the page
+// texture as they arrive, so pages fill up while resources stream in. Space
+// given back by release is reused by later sprites of a similar size.
+class TextureAtlas
+{
+public:
+	TextureAtlas(SDL_Renderer* renderer, int pageSize, int maxSpriteSize);
+	~TextureAtlas();
+
+	bool									canPack(int width, int height) const;
+	bool									pack(SDL_Surface* surface, SDL_Texture** page, SDL_Rect* source);
+	bool									update(SDL_Texture* page, const SDL_Rect& source, SDL_Surface* surface);
+	void									release(SDL_Texture* page, const SDL_Rect& source);
+
+	unsigned int							getPageCount() const;
+	uint64_t								getBytes() const;		// Every page, however full
+
+private:
+	struct Shelf
+	{
+		int		m_y;
+		int		m_height;
+		int		m_x;						// Where the next sprite on this shelf goes
+	};
+
+	struct Page
+	{
+		SDL_Texture*		m_texture;
+		vector<Shelf>		m_shelves;
+		int					m_nextShelfY;
+		vector<SDL_Rect>	m_freeSlots;		// Released sprites, padding included
+	};
+
+	SDL_Renderer*							m_renderer;
+	int										m_pageSize;
+	int										m_maxSpriteSize;
+	vector<Page>							m_pages;
+
+	bool									allocate(Page* page, int width, int height, SDL_Rect* source);
+	bool									addPage();
+};
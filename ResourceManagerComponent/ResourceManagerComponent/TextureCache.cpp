@@ -0,0 +1,266 @@
+#include "stdafx.h"
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include "TextureCache.h"
+#include "Hash.h"
+
+#if defined(_WIN64) || defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	void createDirectories(const string& path)
+	{
+		for (size_t i = 0; i <= path.size(); i++)
+		{
+			if (i == path.size() || path[i] == '/' || path[i] == '\\')
+			{
+				string _directory = path.substr(0, i);
+				if (_directory.empty())
+					continue;
+#if defined(_WIN64) || defined(_WIN32)
+				_mkdir(_directory.c_str());
+#else
+				mkdir(_directory.c_str(), 0755);
+#endif
+			}
+		}
+	}
+}
+
+TextureCache::TextureCache(const string& directory, uint64_t maxBytes) :
+m_directory(directory),
+m_maxBytes(maxBytes),
+m_totalBytes(0),
+m_useCounter(0)
+{
+	createDirectories(m_directory);
+	loadIndex();
+}
+
+TextureCache::~TextureCache()
+{
+	// keeps the use order of entries that were only loaded
+	lock_guard<mutex> _lock(m_mutex);
+	saveIndex();
+}
+
+uint64_t TextureCache::makeKey(const string& path, const unsigned char* data, size_t size)
+{
+	uint64_t _hash = fnv1a64(path.c_str(), path.size());
+	_hash = fnv1a64(&size, sizeof(size), _hash);
+	return fnv1a64(data, size, _hash);
+}
+
+bool TextureCache::load(uint64_t key, CachedTexture* texture)
+{
+	{
+		lock_guard<mutex> _lock(m_mutex);
+		if (m_entries.find(key) == m_entries.end())
+			return false;
+	}
+
+	shared_ptr<MappedFile> _file = make_shared<MappedFile>();
+	bool _valid = _file->open(getEntryPath(key)) && _file->getSize() >= sizeof(TextureCacheHeader);
+
+	const TextureCacheHeader* _header = _valid ? (const TextureCacheHeader*)_file->getData() : nullptr;
+	if (_valid)
+	{
+		_valid = memcmp(_header->m_magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) == 0 &&
+			_header->m_version == TEXTURE_CACHE_VERSION &&
+			_header->m_key == key &&
+			_file->getSize() >= sizeof(TextureCacheHeader) + (uint64_t)_header->m_pitch * _header->m_height;
+	}
+
+	lock_guard<mutex> _lock(m_mutex);
+	if (!_valid)
+	{
+		removeEntry(key);
+		return false;
+	}
+
+	m_entries[key].m_lastUse = ++m_useCounter;
+
+	texture->m_file = _file;
+	texture->m_pixels = _file->getData() + sizeof(TextureCacheHeader);
+	texture->m_format = _header->m_format;
+	texture->m_width = _header->m_width;
+	texture->m_height = _header->m_height;
+	texture->m_pitch = _header->m_pitch;
+	return true;
+}
+
+SDL_Surface* TextureCache::store(uint64_t key, const string& path, SDL_Surface* surface)
+{
+	// palettised pixels mean nothing without their palette
+	if (SDL_ISPIXELFORMAT_INDEXED(surface->format->format))
+	{
+		SDL_Surface* _converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (_converted == nullptr)
+			return surface;
+
+		SDL_FreeSurface(surface);
+		surface = _converted;
+	}
+
+	uint64_t _pathHash = fnv1a64(path.c_str(), path.size());
+	uint64_t _size = sizeof(TextureCacheHeader) + (uint64_t)surface->pitch * surface->h;
+
+	// another loader may be writing the same texture, one file is enough
+	{
+		lock_guard<mutex> _lock(m_mutex);
+		if (m_entries.find(key) != m_entries.end() || !m_storing.insert(key).second)
+			return surface;
+	}
+
+	TextureCacheHeader _header = TextureCacheHeader();
+	memcpy(_header.m_magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+	_header.m_version = TEXTURE_CACHE_VERSION;
+	_header.m_key = key;
+	_header.m_format = surface->format->format;
+	_header.m_width = surface->w;
+	_header.m_height = surface->h;
+	_header.m_pitch = surface->pitch;
+
+	// write to a temporary file first so a half written entry is never loaded
+	string _entryPath = getEntryPath(key);
+	string _temporaryPath = _entryPath + ".tmp";
+
+	FILE* _file = nullptr;
+	fopen_s(&_file, _temporaryPath.c_str(), "wb");
+	bool _written = _file != nullptr;
+	if (_written)
+	{
+		SDL_LockSurface(surface);
+		fwrite(&_header, sizeof(_header), 1, _file);
+		fwrite(surface->pixels, 1, (size_t)surface->pitch * surface->h, _file);
+		SDL_UnlockSurface(surface);
+
+		_written = ferror(_file) == 0;
+		fclose(_file);
+	}
+
+	if (_written)
+	{
+		remove(_entryPath.c_str());
+		_written = rename(_temporaryPath.c_str(), _entryPath.c_str()) == 0;
+	}
+
+	lock_guard<mutex> _lock(m_mutex);
+	m_storing.erase(key);
+
+	if (!_written)
+	{
+		remove(_temporaryPath.c_str());
+		return surface;
+	}
+
+	// only a complete file is published, so a load never sees an entry it cannot read
+	vector<uint64_t> _stale;
+	for (auto& entry : m_entries)
+	{
+		if (entry.second.m_pathHash == _pathHash)
+			_stale.push_back(entry.first);
+	}
+	for (auto& stale : _stale)
+		removeEntry(stale);
+
+	CacheEntry _entry;
+	_entry.m_pathHash = _pathHash;
+	_entry.m_size = _size;
+	_entry.m_lastUse = ++m_useCounter;
+	m_entries[key] = _entry;
+	m_totalBytes += _size;
+
+	evict(key);
+
+	// saved as it changes, so a crash keeps the entries that were already written
+	saveIndex();
+	return surface;
+}
+
+uint64_t TextureCache::getSize()
+{
+	lock_guard<mutex> _lock(m_mutex);
+	return m_totalBytes;
+}
+
+string TextureCache::getEntryPath(uint64_t key) const
+{
+	char _name[32];
+	sprintf_s(_name, sizeof(_name), "%016llx.tex", (unsigned long long)key);
+	return m_directory + "/" + _name;
+}
+
+void TextureCache::removeEntry(uint64_t key)
+{
+	auto _entry = m_entries.find(key);
+	if (_entry == m_entries.end())
+		return;
+
+	m_totalBytes -= _entry->second.m_size;
+	m_entries.erase(_entry);
+	remove(getEntryPath(key).c_str());
+}
+
+void TextureCache::evict(uint64_t keep)
+{
+	if (m_totalBytes <= m_maxBytes)
+		return;
+
+	vector<pair<uint64_t, uint64_t>> _byAge;
+	for (auto& entry : m_entries)
+	{
+		if (entry.first != keep)
+			_byAge.push_back(make_pair(entry.second.m_lastUse, entry.first));
+	}
+	sort(_byAge.begin(), _byAge.end());
+
+	for (auto& entry : _byAge)
+	{
+		if (m_totalBytes <= m_maxBytes)
+			break;
+		removeEntry(entry.second);
+	}
+}
+
+void TextureCache::loadIndex()
+{
+	ifstream _index(m_directory + "/index.txt");
+
+	uint64_t _key;
+	CacheEntry _entry;
+	while (_index >> hex >> _key >> _entry.m_pathHash >> dec >> _entry.m_size >> _entry.m_lastUse)
+	{
+		m_entries[_key] = _entry;
+		m_totalBytes += _entry.m_size;
+		m_useCounter = max(m_useCounter, _entry.m_lastUse);
+	}
+}
+
+void TextureCache::saveIndex()
+{
+	string _indexPath = m_directory + "/index.txt";
+	string _temporaryPath = _indexPath + ".tmp";
+
+	{
+		ofstream _index(_temporaryPath);
+		for (auto& entry : m_entries)
+		{
+			_index << hex << entry.first << " " << entry.second.m_pathHash << " " << dec <<
+				entry.second.m_size << " " << entry.second.m_lastUse << "\n";
+		}
+
+		if (!_index.flush())
+			return;
+	}
+
+	remove(_indexPath.c_str());
+	rename(_temporaryPath.c_str(), _indexPath.c_str());
+}
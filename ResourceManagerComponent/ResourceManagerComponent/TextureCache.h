@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include "SDL_surface.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+const char TEXTURE_CACHE_MAGIC[4] = { 'R', 'T', 'E', 'X' };
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+// Written at the start of every cache file, followed by m_pitch * m_height bytes of pixels
+struct TextureCacheHeader
+{
+	char		m_magic[4];
+	uint32_t	m_version;
+	uint64_t	m_key;
+	uint32_t	m_format;			// SDL_PixelFormatEnum
+	int32_t		m_width;
+	int32_t		m_height;
+	int32_t		m_pitch;
+};
+
+// Decoded pixels served straight from a mapped cache file
+struct CachedTexture
+{
+	CachedTexture() : m_pixels(nullptr), m_format(0), m_width(0), m_height(0), m_pitch(0) {}
+
+	shared_ptr<MappedFile>	m_file;
+	const unsigned char*	m_pixels;
+	uint32_t				m_format;
+	int						m_width;
+	int						m_height;
+	int						m_pitch;
+};
+
+// An on-disk cache of decoded textures so warm starts can skip image decoding.
+// Entries are keyed by a hash of the source path, size and content, so an
+// edited file never matches its old entry. Storing a new entry for a path
+// drops the one it replaces, and the least recently used entries are evicted
+// once the cache grows past its size cap. An entry is only indexed once its
+// file is complete, and the index is saved as it changes. Safe to use from
+// loader threads.
+class TextureCache
+{
+public:
+	TextureCache(const string& directory, uint64_t maxBytes);
+	~TextureCache();
+
+	static uint64_t							makeKey(const string& path, const unsigned char* data, size_t size);
+
+	bool									load(uint64_t key, CachedTexture* texture);
+	SDL_Surface*							store(uint64_t key, const string& path, SDL_Surface* surface);
+
+	uint64_t								getSize();
+
+private:
+	struct CacheEntry
+	{
+		uint64_t	m_pathHash;
+		uint64_t	m_size;
+		uint64_t	m_lastUse;
+	};
+
+	string									m_directory;
+	uint64_t								m_maxBytes;
+	uint64_t								m_totalBytes;
+	uint64_t								m_useCounter;
+
+	map<uint64_t, CacheEntry>				m_entries;
+	set<uint64_t>							m_storing;			// Keys being written, not in m_entries until complete
+	mutex									m_mutex;
+
+	string									getEntryPath(uint64_t key) const;
+	void									removeEntry(uint64_t key);
+	void									evict(uint64_t keep);
+
+	void									loadIndex();
+	void									saveIndex();
+};
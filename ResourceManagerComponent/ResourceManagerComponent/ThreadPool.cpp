@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount) :
+m_activeJobs(0),
+m_stopping(false)
+{
+	if (threadCount == 0)
+		threadCount = thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_workers.push_back(thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		unique_lock<mutex> _lock(m_mutex);
+		m_stopping = true;
+	}
+	m_jobAvailable.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::enqueue(function<void()> job)
+{
+	{
+		unique_lock<mutex> _lock(m_mutex);
+		m_jobs.push(job);
+	}
+	m_jobAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	unique_lock<mutex> _lock(m_mutex);
+	while (!m_jobs.empty() || m_activeJobs > 0)
+		m_jobsFinished.wait(_lock);
+}
+
+void ThreadPool::cancelPending()
+{
+	unique_lock<mutex> _lock(m_mutex);
+	while (!m_jobs.empty())
+		m_jobs.pop();
+
+	if (m_activeJobs == 0)
+		m_jobsFinished.notify_all();
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return m_workers.size();
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		function<void()> _job;
+		{
+			unique_lock<mutex> _lock(m_mutex);
+			while (!m_stopping && m_jobs.empty())
+				m_jobAvailable.wait(_lock);
+
+			if (m_stopping && m_jobs.empty())
+				return;
+
+			_job = m_jobs.front();
+			m_jobs.pop();
+			m_activeJobs++;
+		}
+
+		_job();
+
+		{
+			unique_lock<mutex> _lock(m_mutex);
+			m_activeJobs--;
+			if (m_jobs.empty() && m_activeJobs == 0)
+				m_jobsFinished.notify_all();
+		}
+	}
+}
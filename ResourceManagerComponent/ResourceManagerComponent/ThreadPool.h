@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// A fixed set of worker threads that run queued jobs in FIFO order.
+// Used by the ResourceManager to read and decode files off the main thread.
+class ThreadPool
+{
+public:
+	ThreadPool(unsigned int threadCount = 0);	// 0 uses one worker per hardware thread
+	~ThreadPool();
+
+	void									enqueue(function<void()> job);
+	void									wait();	// Blocks until every queued job has finished
+	void									cancelPending();	// Drops jobs that have not started yet
+
+	unsigned int							getThreadCount() const;
+
+private:
+	vector<thread>							m_workers;
+	queue<function<void()>>					m_jobs;
+
+	mutex									m_mutex;
+	condition_variable						m_jobAvailable;
+	condition_variable						m_jobsFinished;
+
+	unsigned int							m_activeJobs;
+	bool									m_stopping;
+
+	void									workerLoop();
+};